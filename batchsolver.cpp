@@ -0,0 +1,525 @@
+/*
+    Copyright 2017 John Selbie
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "stdafx.h"
+#include "batchsolver.h"
+#include "puzzlereader.h"
+
+// input is handed to the workers in blocks of this many chunks per worker
+const size_t BATCH_CHUNKS_PER_WORKER = 16;
+
+// the reader gets at most this many blocks ahead of the writer.  Chunks are written out in order, so this bounds how
+// much input and output can pile up behind a slow chunk
+const size_t BATCH_BLOCKS_IN_FLIGHT = 4;
+
+// size of a typical input line, an 81 character puzzle and a line break
+const size_t BATCH_LINE_SIZE = 82;
+
+BatchStats::BatchStats() :
+puzzles(0),
+solved(0),
+errors(0),
+nosolution(0),
+unique(0),
+multiple(0),
+seconds(0)
+{
+}
+
+void BatchStats::Add(const BatchStats& other)
+{
+    puzzles += other.puzzles;
+    solved += other.solved;
+    errors += other.errors;
+    nosolution += other.nosolution;
+    unique += other.unique;
+    multiple += other.multiple;
+    solvestats.Add(other.solvestats);
+}
+
+double BatchStats::PuzzlesPerSecond() const
+{
+    if (seconds <= 0)
+        return 0;
+
+    return puzzles / seconds;
+}
+
+BatchOptions::BatchOptions() :
+threadcount(0),
+chunksize(64),
+engine(ENGINE_SCAN),
+fSearch(false),
+fDancingLinks(false),
+countlimit(0),
+fStats(false)
+{
+}
+
+BatchChunk::BatchChunk() :
+begin(nullptr),
+end(nullptr),
+fDone(false)
+{
+}
+
+BatchBlock::BatchBlock() :
+writecount(0)
+{
+}
+
+BatchWorker::BatchWorker()
+{
+    board.SetLogLevel(LOG_OFF);
+    dlx.SetLogLevel(LOG_OFF);
+}
+
+void BatchWorker::PushBack(BatchChunk *chunk)
+{
+    std::lock_guard<std::mutex> lock(queuelock);
+
+    queue.push_back(chunk);
+}
+
+bool BatchWorker::PopFront(BatchChunk*& chunk)
+{
+    std::lock_guard<std::mutex> lock(queuelock);
+
+    if (queue.empty())
+        return false;
+
+    chunk = queue.front();
+    queue.pop_front();
+    return true;
+}
+
+bool BatchWorker::StealBack(BatchChunk*& chunk)
+{
+    std::lock_guard<std::mutex> lock(queuelock);
+
+    if (queue.empty())
+        return false;
+
+    chunk = queue.back();
+    queue.pop_back();
+    return true;
+}
+
+BatchSolver::BatchSolver(const BatchOptions& options) :
+m_chunksize(options.chunksize),
+m_fDancingLinks(options.fDancingLinks),
+m_countlimit(options.countlimit),
+m_fStats(options.fStats),
+m_blockcount(0),
+m_fStopping(false)
+{
+    int threadcount = options.threadcount;
+
+    if (threadcount <= 0)
+    {
+        threadcount = (int)std::thread::hardware_concurrency();
+    }
+    if (threadcount <= 0)
+    {
+        threadcount = 1;
+    }
+    if (m_chunksize == 0)
+    {
+        m_chunksize = 1;
+    }
+
+    for (int index = 0; index < threadcount; index++)
+    {
+        BatchWorker *worker = new BatchWorker();
+        worker->board.SetEngine(options.engine);
+        worker->board.SetSearchFallback(options.fSearch);
+        worker->board.SetStats(options.fStats);
+        m_workers.push_back(worker);
+    }
+}
+
+BatchSolver::~BatchSolver()
+{
+    for (size_t index = 0; index < m_workers.size(); index++)
+    {
+        delete m_workers[index];
+    }
+}
+
+const BatchStats& BatchSolver::GetStats() const
+{
+    return m_stats;
+}
+
+int BatchSolver::GetThreadCount() const
+{
+    return (int)m_workers.size();
+}
+
+bool BatchSolver::SolveFile(const std::string& filename, std::ostream& out)
+{
+    if (filename == "-")
+    {
+        return SolveStream(std::cin, out);
+    }
+
+    PuzzleFile file;
+    std::vector<PuzzleRange> blocks;
+    size_t blocksize = m_chunksize * BATCH_LINE_SIZE * BATCH_CHUNKS_PER_WORKER * m_workers.size();
+
+    if (file.Open(filename) == false)
+    {
+        return false;
+    }
+
+    m_stats = BatchStats();
+
+    auto start = std::chrono::steady_clock::now();
+
+    StartWorkers();
+
+    // the workers read straight out of the file mapping
+    PuzzleFile::SplitLines(file.Begin(), file.End(), blocksize, blocks);
+    for (size_t index = 0; index < blocks.size(); index++)
+    {
+        AddBlock(new BatchBlock(), blocks[index].begin, blocks[index].end, out);
+    }
+
+    WriteChunks(out, 0);
+    StopWorkers();
+    out.flush();
+
+    auto finish = std::chrono::steady_clock::now();
+    m_stats.seconds = std::chrono::duration<double>(finish - start).count();
+
+    return true;
+}
+
+bool BatchSolver::SolveStream(std::istream& in, std::ostream& out)
+{
+    std::string line;
+    BatchBlock *block;
+    size_t blocklines = m_chunksize * BATCH_CHUNKS_PER_WORKER * m_workers.size();
+    size_t linecount = 0;
+
+    m_stats = BatchStats();
+
+    auto start = std::chrono::steady_clock::now();
+
+    StartWorkers();
+
+    // the next block is read while the workers solve the ones before it
+    block = new BatchBlock();
+    block->text.reserve(blocklines * BATCH_LINE_SIZE);
+
+    while (std::getline(in, line))
+    {
+        block->text += line;
+        block->text += '\n';
+        linecount++;
+
+        if (linecount == blocklines)
+        {
+            AddBlock(block, block->text.data(), block->text.data() + block->text.size(), out);
+            block = new BatchBlock();
+            block->text.reserve(blocklines * BATCH_LINE_SIZE);
+            linecount = 0;
+        }
+    }
+
+    AddBlock(block, block->text.data(), block->text.data() + block->text.size(), out);
+
+    WriteChunks(out, 0);
+    StopWorkers();
+    out.flush();
+
+    auto finish = std::chrono::steady_clock::now();
+    m_stats.seconds = std::chrono::duration<double>(finish - start).count();
+
+    return true;
+}
+
+void BatchSolver::StartWorkers()
+{
+    m_blockcount = 0;
+    m_fStopping = false;
+
+    for (size_t index = 0; index < m_workers.size(); index++)
+    {
+        m_workers[index]->thread = std::thread(&BatchSolver::WorkerThread, this, m_workers[index]);
+    }
+}
+
+void BatchSolver::StopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_worklock);
+        m_fStopping = true;
+    }
+    m_worksignal.notify_all();
+
+    for (size_t index = 0; index < m_workers.size(); index++)
+    {
+        m_workers[index]->thread.join();
+    }
+}
+
+void BatchSolver::AddBlock(BatchBlock *block, const char *begin, const char *end, std::ostream& out)
+{
+    size_t workercount = m_workers.size();
+
+    m_ranges.clear();
+    PuzzleFile::SplitLines(begin, end, m_chunksize * BATCH_LINE_SIZE, m_ranges);
+
+    block->chunks.resize(m_ranges.size());
+    for (size_t index = 0; index < m_ranges.size(); index++)
+    {
+        block->chunks[index].begin = m_ranges[index].begin;
+        block->chunks[index].end = m_ranges[index].end;
+    }
+
+    // give each worker an equal run of consecutive chunks.  Anything left over from earlier blocks is ahead
+    // of them in the queue, so the workers stay close to input order
+    size_t chunkcount = block->chunks.size();
+    for (size_t index = 0; index < workercount; index++)
+    {
+        size_t first = (chunkcount * index) / workercount;
+        size_t last = (chunkcount * (index + 1)) / workercount;
+
+        for (size_t chunkindex = first; chunkindex < last; chunkindex++)
+        {
+            m_workers[index]->PushBack(&block->chunks[chunkindex]);
+        }
+    }
+
+    m_blocks.push_back(block);
+
+    {
+        std::lock_guard<std::mutex> lock(m_worklock);
+        m_blockcount++;
+    }
+    m_worksignal.notify_all();
+
+    WriteChunks(out, BATCH_BLOCKS_IN_FLIGHT);
+}
+
+void BatchSolver::WriteChunks(std::ostream& out, size_t maxblocks)
+{
+    while (m_blocks.empty() == false)
+    {
+        BatchBlock *block = m_blocks.front();
+        bool fWait = (m_blocks.size() > maxblocks);
+
+        while (block->writecount < block->chunks.size())
+        {
+            BatchChunk& chunk = block->chunks[block->writecount];
+
+            {
+                std::unique_lock<std::mutex> lock(m_donelock);
+                while (chunk.fDone == false)
+                {
+                    if (fWait == false)
+                        return;
+
+                    m_donesignal.wait(lock);
+                }
+            }
+
+            out.write(chunk.output.data(), chunk.output.size());
+            m_stats.Add(chunk.stats);
+            std::string().swap(chunk.output);
+            block->writecount++;
+        }
+
+        m_blocks.pop_front();
+        delete block;
+    }
+}
+
+void BatchSolver::WorkerThread(BatchWorker *worker)
+{
+    BatchChunk *chunk;
+    uint64_t blockcount = 0;
+
+    while (true)
+    {
+        // sleep until another block is queued, or the run is over
+        {
+            std::unique_lock<std::mutex> lock(m_worklock);
+            while ((m_blockcount == blockcount) && (m_fStopping == false))
+            {
+                m_worksignal.wait(lock);
+            }
+
+            if (m_blockcount == blockcount)
+                return;
+
+            blockcount = m_blockcount;
+        }
+
+        while (GetNextChunk(worker, chunk))
+        {
+            SolveChunk(worker, *chunk);
+
+            {
+                std::lock_guard<std::mutex> lock(m_donelock);
+                chunk->fDone = true;
+            }
+            m_donesignal.notify_one();
+        }
+    }
+}
+
+bool BatchSolver::GetNextChunk(BatchWorker *worker, BatchChunk*& chunk)
+{
+    if (worker->PopFront(chunk))
+    {
+        return true;
+    }
+
+    // our own queue is empty, try to steal from the other workers starting with the next one over.
+    // Chunks are only queued before m_blockcount moves on, so once every queue is empty the worker can go back to waiting.
+    size_t workercount = m_workers.size();
+    size_t self = 0;
+    while (m_workers[self] != worker)
+    {
+        self++;
+    }
+
+    for (size_t offset = 1; offset < workercount; offset++)
+    {
+        BatchWorker *victim = m_workers[(self + offset) % workercount];
+        if (victim->StealBack(chunk))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void BatchSolver::SolveChunk(BatchWorker *worker, BatchChunk& chunk)
+{
+    const char *pos = chunk.begin;
+    const char *record;
+    size_t length;
+
+    chunk.output.reserve((chunk.end - chunk.begin) + BATCH_LINE_SIZE);
+
+    while (PuzzleFile::NextRecord(pos, chunk.end, record, length))
+    {
+        if (m_countlimit != 0)
+        {
+            CountLine(worker, record, length, chunk);
+        }
+        else
+        {
+            SolveLine(worker, record, length, chunk);
+        }
+    }
+}
+
+void BatchSolver::SolveLine(BatchWorker *worker, const char *line, size_t length, BatchChunk& chunk)
+{
+    char szLine[82];
+    bool fLoaded;
+    bool fSolved = false;
+    bool fValid = false;
+
+    chunk.stats.puzzles++;
+
+    if (m_fDancingLinks)
+    {
+        DlxSolver& dlx = worker->dlx;
+
+        fLoaded = dlx.LoadFromBuffer(line, length);
+        if (fLoaded)
+        {
+            fSolved = dlx.Solve();
+            fValid = dlx.IsValid();
+            dlx.GetBoardLine(szLine);
+        }
+    }
+    else
+    {
+        SudokuBoard& board = worker->board;
+
+        board.Reset();
+        fLoaded = board.LoadFromBuffer(line, length);
+        if (fLoaded)
+        {
+            fSolved = board.Solve();
+            fValid = board.IsValid();
+            board.GetBoardLine(szLine);
+
+            if (m_fStats)
+            {
+                chunk.stats.solvestats.Add(board.GetStats());
+            }
+        }
+    }
+
+    // a grid that repeats a value in a row, column, or square isn't a puzzle, even when every cell is filled in
+    if ((fLoaded == false) || (fValid == false))
+    {
+        chunk.stats.errors++;
+        chunk.output += "ERROR\n";
+        return;
+    }
+
+    if (fSolved)
+    {
+        chunk.stats.solved++;
+    }
+
+    chunk.output.append(szLine, 81);
+    chunk.output += '\n';
+}
+
+void BatchSolver::CountLine(BatchWorker *worker, const char *line, size_t length, BatchChunk& chunk)
+{
+    SudokuBoard& board = worker->board;
+    char szCount[16];
+
+    chunk.stats.puzzles++;
+
+    board.Reset();
+
+    // a grid that repeats a value is an error here too, so the counts agree with what solve mode reports
+    if ((board.LoadFromBuffer(line, length) == false) || (board.IsValid() == false))
+    {
+        chunk.stats.errors++;
+        chunk.output += "ERROR\n";
+        return;
+    }
+
+    int count = board.CountSolutions(m_countlimit);
+
+    if (count == 0)
+    {
+        chunk.stats.nosolution++;
+    }
+    else if (count == 1)
+    {
+        chunk.stats.unique++;
+    }
+    else
+    {
+        chunk.stats.multiple++;
+    }
+
+    snprintf(szCount, sizeof(szCount), "%d\n", count);
+    chunk.output += szCount;
+}
@@ -0,0 +1,159 @@
+/*
+    Copyright 2017 John Selbie
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef SUDOKU_BATCH_SOLVER_H
+#define SUDOKU_BATCH_SOLVER_H
+
+#include "sudokuboard.h"
+#include "dlxsolver.h"
+#include "puzzlereader.h"
+
+// BatchStats holds the totals for a batch run
+struct BatchStats
+{
+    uint64_t puzzles;  // number of puzzle lines processed
+    uint64_t solved;   // number of puzzles that were solved
+    uint64_t errors;   // number of lines that could not be parsed, or that repeat a value in a row, column, or square
+    uint64_t nosolution;  // count mode only - puzzles with no solution
+    uint64_t unique;      // count mode only - puzzles with exactly one solution
+    uint64_t multiple;    // count mode only - puzzles with more than one solution
+    SolveStats solvestats;  // total of the per-board algorithm stats, only filled in when BatchOptions::fStats is set
+    double seconds;    // wall clock time of the run
+
+    BatchStats();
+    void Add(const BatchStats& other);  // adds the counts (not the time) of another set of stats
+    double PuzzlesPerSecond() const;
+};
+
+// BatchOptions controls how a BatchSolver runs
+struct BatchOptions
+{
+    int threadcount;      // number of workers, 0 uses one worker per hardware thread
+    size_t chunksize;     // number of puzzle lines per chunk
+    SOLVE_ENGINE engine;  // engine each board uses to solve
+    bool fSearch;         // finish puzzles that logic can't solve with the backtracking search
+    bool fDancingLinks;   // solve with DlxSolver instead of SudokuBoard (engine and fSearch are ignored)
+    int countlimit;       // when non-zero, count solutions up to this limit instead of solving (always uses SudokuBoard)
+    bool fStats;          // collect the SudokuBoard algorithm stats of every puzzle into BatchStats::solvestats
+
+    BatchOptions();
+};
+
+// A BatchChunk is a range of input lines that one worker solves as a unit.
+// The result lines for the chunk are collected in "output" and written out in chunk order once the chunk is done
+struct BatchChunk
+{
+    const char *begin;
+    const char *end;
+    std::string output;
+    BatchStats stats;
+    bool fDone;
+
+    BatchChunk();
+};
+
+// A BatchBlock is a run of input that is split into chunks and handed to the workers in one go.  Stream input is
+// copied into "text", file input points straight into the mapping.  Blocks are written out and freed in input order
+struct BatchBlock
+{
+    std::string text;
+    std::vector<BatchChunk> chunks;
+    size_t writecount;  // number of chunks already written out
+
+    BatchBlock();
+};
+
+// A BatchWorker owns one board (of each engine type) and a queue of chunks.  The worker takes chunks from the front of its own queue.
+// Once its queue is empty it steals chunks from the back of the other workers' queues.
+struct BatchWorker
+{
+    SudokuBoard board;
+    DlxSolver dlx;
+    std::thread thread;
+
+    std::mutex queuelock;  // protects queue
+    std::deque<BatchChunk*> queue;
+
+    BatchWorker();
+    void PushBack(BatchChunk *chunk);
+    bool PopFront(BatchChunk*& chunk);
+    bool StealBack(BatchChunk*& chunk);
+};
+
+// BatchSolver solves a stream of puzzles, one 81 character puzzle per line, and writes one 81 character line
+// per puzzle in the same order.  Unsolved cells are written as '.'.  Blank lines and lines starting with '#' are skipped.
+// Lines that can not be parsed as a puzzle produce an "ERROR" line so that output lines stay matched up with the input.
+// In count mode (BatchOptions::countlimit) the output line for each puzzle is its number of solutions, stopping at the limit.
+// Input is split into chunks of lines that are solved in parallel by a pool of workers that lives for the whole run.
+// Each worker reuses a single SudokuBoard with logging turned off.  The calling thread reads the input a block at a
+// time while the workers solve the blocks before it, and writes the chunks out in input order as they complete.
+class BatchSolver
+{
+public:
+    BatchSolver(const BatchOptions& options);
+    ~BatchSolver();
+
+    // filename of "-" reads from stdin.  Files are memory mapped and solved in place without being copied.
+    bool SolveFile(const std::string& filename, std::ostream& out);
+    bool SolveStream(std::istream& in, std::ostream& out);
+
+    const BatchStats& GetStats() const;
+    int GetThreadCount() const;
+
+protected:
+    std::vector<BatchWorker*> m_workers;
+    size_t m_chunksize;  // number of puzzle lines per chunk
+    bool m_fDancingLinks;
+    int m_countlimit;
+    bool m_fStats;
+    BatchStats m_stats;
+
+    std::vector<PuzzleRange> m_ranges;
+    std::deque<BatchBlock*> m_blocks;   // blocks handed to the workers and not yet written out, oldest first.  Only used by the calling thread
+    std::mutex m_donelock;              // protects BatchChunk::fDone
+    std::condition_variable m_donesignal;
+    std::mutex m_worklock;              // protects m_blockcount and m_fStopping
+    std::condition_variable m_worksignal;
+    uint64_t m_blockcount;              // number of blocks handed to the workers so far, idle workers wait for it to change
+    bool m_fStopping;
+
+    void StartWorkers();
+    void StopWorkers();
+
+    // AddBlock splits [begin,end) into chunks on line boundaries and queues them on the workers.  It then writes
+    // out whatever has finished, waiting only if too many blocks are in flight.  The block is freed once written.
+    void AddBlock(BatchBlock *block, const char *begin, const char *end, std::ostream& out);
+
+    // WriteChunks writes finished chunks to "out" in input order.  It waits for chunks to finish until no more than
+    // "maxblocks" blocks are left in flight, then writes only the chunks that are already done.
+    void WriteChunks(std::ostream& out, size_t maxblocks);
+
+    void WorkerThread(BatchWorker *worker);
+    bool GetNextChunk(BatchWorker *worker, BatchChunk*& chunk);
+    void SolveChunk(BatchWorker *worker, BatchChunk& chunk);
+
+    // SolveLine solves the puzzle in "line" and appends the result line (including the line break) to the chunk output
+    void SolveLine(BatchWorker *worker, const char *line, size_t length, BatchChunk& chunk);
+
+    // CountLine counts the solutions of the puzzle in "line" and appends the count (including the line break) to the chunk output
+    void CountLine(BatchWorker *worker, const char *line, size_t length, BatchChunk& chunk);
+
+private:
+    // disable assignment and copy constructor
+    BatchSolver(const BatchSolver& other) {};
+    BatchSolver& operator=(const BatchSolver& other) { return *this; };
+};
+
+#endif
@@ -0,0 +1,349 @@
+/*
+    Copyright 2017 John Selbie
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// benchmark is a separate executable from the solver app.  It runs each engine over the puzzle corpora in the
+// corpus directory and writes one JSON line per engine and corpus to stdout, so that the output of runs on
+// different commits can be diffed or loaded into a script.  Every puzzle is timed on its own (Reset, load, and solve)
+// on each pass, and its latency is the median of its passes, so each distinct puzzle counts once in the percentiles.
+// The cost of setting up a board for the next puzzle is reported first, as "setup" lines.
+
+#include "stdafx.h"
+#include "sudokuboard.h"
+#include "dlxsolver.h"
+#include "puzzlereader.h"
+#include <algorithm>
+
+struct BenchEngine
+{
+    const char *name;
+    SOLVE_ENGINE engine;
+    bool fSearch;
+    bool fDancingLinks;
+};
+
+static const BenchEngine g_engines[] =
+{
+    { "scan",             ENGINE_SCAN,      false, false },
+    { "propagate",        ENGINE_PROPAGATE, false, false },
+    { "adaptive",         ENGINE_ADAPTIVE,  false, false },
+    { "scan+search",      ENGINE_SCAN,      true,  false },
+    { "propagate+search", ENGINE_PROPAGATE, true,  false },
+    { "adaptive+search",  ENGINE_ADAPTIVE,  true,  false },
+    { "dlx",              ENGINE_SCAN,      false, true  }
+};
+
+static const char *g_corpora[] =
+{
+    "corpus/easy.txt",
+    "corpus/nyt_hard.txt",
+    "corpus/17clue.txt",
+    "corpus/hardest.txt"
+};
+
+struct BenchResult
+{
+    size_t puzzles;
+    size_t solved;            // solved and valid, from the first timed pass
+    size_t solves;            // number of timed solves, puzzles times passes
+    double seconds;           // total time of all timed passes
+    std::vector<double> latencies;  // microseconds, the median of the timed passes of each puzzle
+};
+
+// LoadCorpus reads the puzzle lines of a corpus file.  Comment and blank lines are skipped
+static bool LoadCorpus(const std::string& filename, std::vector<std::string>& puzzles)
+{
+    PuzzleFile file;
+    const char *pos;
+    const char *record;
+    size_t length;
+
+    if (file.Open(filename) == false)
+    {
+        return false;
+    }
+
+    pos = file.Begin();
+    while (PuzzleFile::NextRecord(pos, file.End(), record, length))
+    {
+        puzzles.push_back(std::string(record, length));
+    }
+
+    return true;
+}
+
+// VerifyCorpus checks that every puzzle has exactly one solution.  Returns the number of puzzles that don't
+static size_t VerifyCorpus(const std::string& filename, const std::vector<std::string>& puzzles)
+{
+    SudokuBoard board;
+    size_t badcount = 0;
+
+    board.SetLogLevel(LOG_OFF);
+
+    for (size_t index = 0; index < puzzles.size(); index++)
+    {
+        board.Reset();
+        if ((board.LoadFromBuffer(puzzles[index].data(), puzzles[index].size()) == false) || (board.CountSolutions(2) != 1))
+        {
+            std::cerr << filename << ": puzzle " << (index + 1) << " does not have a unique solution" << std::endl;
+            badcount++;
+        }
+    }
+
+    return badcount;
+}
+
+static bool SolveOne(const BenchEngine& engine, SudokuBoard& board, DlxSolver& dlx, const std::string& puzzle)
+{
+    if (engine.fDancingLinks)
+    {
+        if (dlx.LoadFromBuffer(puzzle.data(), puzzle.size()) == false)
+            return false;
+
+        return dlx.Solve() && dlx.IsValid();
+    }
+
+    board.Reset();
+    if (board.LoadFromBuffer(puzzle.data(), puzzle.size()) == false)
+        return false;
+
+    return board.Solve() && board.IsValid();
+}
+
+static void RunEngine(const BenchEngine& engine, const std::vector<std::string>& puzzles, int repeat, BenchResult& result)
+{
+    SudokuBoard board;
+    DlxSolver dlx;
+
+    board.SetLogLevel(LOG_OFF);
+    board.SetEngine(engine.engine);
+    board.SetSearchFallback(engine.fSearch);
+    dlx.SetLogLevel(LOG_OFF);
+
+    std::vector<double> passes(puzzles.size() * repeat);  // passes[index * repeat + pass]
+
+    result.puzzles = puzzles.size();
+    result.solved = 0;
+    result.solves = passes.size();
+    result.seconds = 0;
+    result.latencies.clear();
+    result.latencies.reserve(puzzles.size());
+
+    // one untimed pass to warm up the caches and the branch predictors
+    for (size_t index = 0; index < puzzles.size(); index++)
+    {
+        SolveOne(engine, board, dlx, puzzles[index]);
+    }
+
+    for (int pass = 0; pass < repeat; pass++)
+    {
+        for (size_t index = 0; index < puzzles.size(); index++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            bool fSolved = SolveOne(engine, board, dlx, puzzles[index]);
+            auto finish = std::chrono::steady_clock::now();
+
+            double seconds = std::chrono::duration<double>(finish - start).count();
+            result.seconds += seconds;
+            passes[(index * repeat) + pass] = seconds * 1000000.0;
+
+            if (fSolved && (pass == 0))
+            {
+                result.solved++;
+            }
+        }
+    }
+
+    for (size_t index = 0; index < puzzles.size(); index++)
+    {
+        std::vector<double>::iterator first = passes.begin() + (index * repeat);
+        std::vector<double>::iterator middle = first + (repeat / 2);
+
+        std::nth_element(first, middle, first + repeat);
+        result.latencies.push_back(*middle);
+    }
+
+    std::sort(result.latencies.begin(), result.latencies.end());
+}
+
+// BenchSetup times the per-puzzle setup of a reused board, first with a full Init and then with Reset.
+// Each call is followed by loading a puzzle so that both start from a dirty board
+static void BenchSetup(const std::string& puzzle)
+{
+    const int calls = 100000;
+    SudokuBoard board;
+    char szLine[256];
+
+    board.SetLogLevel(LOG_OFF);
+
+    for (int method = 0; method < 2; method++)
+    {
+        double seconds = 0;
+
+        for (int index = 0; index < calls; index++)
+        {
+            board.LoadFromBuffer(puzzle.data(), puzzle.size());
+
+            auto start = std::chrono::steady_clock::now();
+            if (method == 0)
+            {
+                board.Init();
+            }
+            else
+            {
+                board.Reset();
+            }
+            auto finish = std::chrono::steady_clock::now();
+
+            seconds += std::chrono::duration<double>(finish - start).count();
+        }
+
+        snprintf(szLine, sizeof(szLine), "{\"setup\":\"%s\",\"calls\":%d,\"mean_ns\":%.1f}", (method == 0) ? "init" : "reset", calls, seconds * 1000000000.0 / calls);
+        std::cout << szLine << '\n';
+    }
+}
+
+// nearest rank percentile of a sorted list
+static double Percentile(const std::vector<double>& sorted, double fraction)
+{
+    if (sorted.empty())
+        return 0;
+
+    size_t rank = (size_t)(fraction * sorted.size());
+    if (rank >= sorted.size())
+    {
+        rank = sorted.size() - 1;
+    }
+
+    return sorted[rank];
+}
+
+static std::string GetCorpusName(const std::string& filename)
+{
+    size_t start = filename.find_last_of("/\\");
+    start = (start == std::string::npos) ? 0 : (start + 1);
+
+    size_t end = filename.rfind('.');
+    if ((end == std::string::npos) || (end < start))
+    {
+        end = filename.size();
+    }
+
+    return filename.substr(start, end - start);
+}
+
+static void PrintResult(const std::string& corpus, const BenchEngine& engine, size_t invalid, const BenchResult& result)
+{
+    char szLine[512];
+    double mean = 0;
+
+    for (size_t index = 0; index < result.latencies.size(); index++)
+    {
+        mean += result.latencies[index];
+    }
+    if (result.latencies.empty() == false)
+    {
+        mean /= result.latencies.size();
+    }
+
+    snprintf(szLine, sizeof(szLine),
+        "{\"corpus\":\"%s\",\"engine\":\"%s\",\"puzzles\":%zu,\"invalid\":%zu,\"solved\":%zu,\"solve_rate\":%.4f,"
+        "\"puzzles_per_sec\":%.1f,\"mean_us\":%.2f,\"p50_us\":%.2f,\"p99_us\":%.2f,\"p999_us\":%.2f}",
+        corpus.c_str(),
+        engine.name,
+        result.puzzles,
+        invalid,
+        result.solved,
+        result.puzzles ? ((double)result.solved / result.puzzles) : 0.0,
+        (result.seconds > 0) ? (result.solves / result.seconds) : 0.0,
+        mean,
+        Percentile(result.latencies, 0.50),
+        Percentile(result.latencies, 0.99),
+        Percentile(result.latencies, 0.999));
+
+    std::cout << szLine << '\n';
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> corpora;
+    std::string enginename;
+    int repeat = 5;
+
+    for (int index = 1; index < argc; index++)
+    {
+        std::string arg = argv[index];
+
+        if ((arg == "-engine") && (index + 1 < argc))
+        {
+            index++;
+            enginename = argv[index];
+        }
+        else if ((arg == "-repeat") && (index + 1 < argc))
+        {
+            index++;
+            repeat = atoi(argv[index]);
+        }
+        else if ((arg == "-h") || (arg == "-help"))
+        {
+            std::cout << "Usage: " << argv[0] << " [-engine scan|propagate|adaptive|scan+search|propagate+search|adaptive+search|dlx] [-repeat N] [corpus files...]" << std::endl;
+            std::cout << "       with no corpus files, the corpus/*.txt sets are used" << std::endl;
+            return 0;
+        }
+        else
+        {
+            corpora.push_back(arg);
+        }
+    }
+
+    if (repeat <= 0)
+    {
+        repeat = 1;
+    }
+
+    if (corpora.empty())
+    {
+        corpora.assign(g_corpora, g_corpora + sizeof(g_corpora) / sizeof(g_corpora[0]));
+    }
+
+    for (size_t corpusindex = 0; corpusindex < corpora.size(); corpusindex++)
+    {
+        std::vector<std::string> puzzles;
+
+        if (LoadCorpus(corpora[corpusindex], puzzles) == false)
+        {
+            std::cerr << "Failed to open " << corpora[corpusindex] << std::endl;
+            return 1;
+        }
+
+        if ((corpusindex == 0) && (puzzles.empty() == false))
+        {
+            BenchSetup(puzzles[0]);
+        }
+
+        size_t invalid = VerifyCorpus(corpora[corpusindex], puzzles);
+
+        for (const BenchEngine& engine : g_engines)
+        {
+            if ((enginename.empty() == false) && (enginename != engine.name))
+                continue;
+
+            BenchResult result;
+            RunEngine(engine, puzzles, repeat, result);
+            PrintResult(GetCorpusName(corpora[corpusindex]), engine, invalid, result);
+        }
+    }
+
+    return 0;
+}
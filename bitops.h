@@ -0,0 +1,101 @@
+/*
+    Copyright 2017 John Selbie
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef SUDOKU_BITOPS_H
+#define SUDOKU_BITOPS_H
+
+// Bit operations on candidate masks (see Cell::_bitmask) and position masks.
+// The inline versions use compiler intrinsics, which become popcnt/tzcnt/blsr instructions when the target has them.
+// The Const versions are constexpr fallbacks that can also be used in constant expressions.
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+constexpr int PopCountConst(uint32_t w)
+{
+    return (w == 0) ? 0 : (1 + PopCountConst(w & (w - 1)));
+}
+
+// w must not be 0
+constexpr int LowestBitIndexConst(uint32_t w)
+{
+    return (w & 0x01) ? 0 : (1 + LowestBitIndexConst(w >> 1));
+}
+
+// returns the number of bits set in w
+inline int PopCount(uint32_t w)
+{
+#if defined(__GNUC__)
+    return __builtin_popcount(w);
+#elif defined(_MSC_VER) && defined(__AVX__)
+    return (int)__popcnt(w);  // popcnt is only guaranteed on processors with AVX
+#else
+    return PopCountConst(w);
+#endif
+}
+
+// returns the index (0 is the least significant bit) of the lowest bit set in w.  w must not be 0
+inline int LowestBitIndex(uint32_t w)
+{
+    assert(w != 0);
+#if defined(__GNUC__)
+    return __builtin_ctz(w);
+#elif defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, w);
+    return (int)index;
+#else
+    return LowestBitIndexConst(w);
+#endif
+}
+
+// returns w with the lowest bit cleared
+inline uint32_t ClearLowestBit(uint32_t w)
+{
+    return w & (w - 1);
+}
+
+// BitIndexes and BitValues let a range based for loop walk the bits of a mask from lowest to highest:
+//     for (int index : BitIndexes(mask))   index is 0 for the least significant bit
+//     for (int value : BitValues(mask))    value is 1 for the least significant bit (candidate value of a Cell mask)
+template <int BASE>
+class BitRange
+{
+public:
+    class iterator
+    {
+    public:
+        explicit iterator(uint32_t w) : _w(w) {}
+        int operator*() const { return LowestBitIndex(_w) + BASE; }
+        iterator& operator++() { _w = ClearLowestBit(_w); return *this; }
+        bool operator!=(const iterator& other) const { return _w != other._w; }
+
+    private:
+        uint32_t _w;
+    };
+
+    explicit BitRange(uint32_t w) : _w(w) {}
+    iterator begin() const { return iterator(_w); }
+    iterator end() const { return iterator(0); }
+
+private:
+    uint32_t _w;
+};
+
+typedef BitRange<0> BitIndexes;
+typedef BitRange<1> BitValues;
+
+#endif
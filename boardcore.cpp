@@ -0,0 +1,574 @@
+/*
+    Copyright 2017 John Selbie
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "stdafx.h"
+#include "bitops.h"
+#include "cell.h"
+#include "boardcore.h"
+
+const uint8_t g_setCells[27][9] =
+{
+    // rows
+    { 0, 1, 2, 3, 4, 5, 6, 7, 8},
+    { 9,10,11,12,13,14,15,16,17},
+    {18,19,20,21,22,23,24,25,26},
+    {27,28,29,30,31,32,33,34,35},
+    {36,37,38,39,40,41,42,43,44},
+    {45,46,47,48,49,50,51,52,53},
+    {54,55,56,57,58,59,60,61,62},
+    {63,64,65,66,67,68,69,70,71},
+    {72,73,74,75,76,77,78,79,80},
+    // columns
+    { 0, 9,18,27,36,45,54,63,72},
+    { 1,10,19,28,37,46,55,64,73},
+    { 2,11,20,29,38,47,56,65,74},
+    { 3,12,21,30,39,48,57,66,75},
+    { 4,13,22,31,40,49,58,67,76},
+    { 5,14,23,32,41,50,59,68,77},
+    { 6,15,24,33,42,51,60,69,78},
+    { 7,16,25,34,43,52,61,70,79},
+    { 8,17,26,35,44,53,62,71,80},
+    // squares
+    { 0, 1, 2, 9,10,11,18,19,20},
+    { 3, 4, 5,12,13,14,21,22,23},
+    { 6, 7, 8,15,16,17,24,25,26},
+    {27,28,29,36,37,38,45,46,47},
+    {30,31,32,39,40,41,48,49,50},
+    {33,34,35,42,43,44,51,52,53},
+    {54,55,56,63,64,65,72,73,74},
+    {57,58,59,66,67,68,75,76,77},
+    {60,61,62,69,70,71,78,79,80}
+};
+
+const uint8_t g_cellSets[81][3] =
+{
+    { 0, 9,18},
+    { 0,10,18},
+    { 0,11,18},
+    { 0,12,19},
+    { 0,13,19},
+    { 0,14,19},
+    { 0,15,20},
+    { 0,16,20},
+    { 0,17,20},
+    { 1, 9,18},
+    { 1,10,18},
+    { 1,11,18},
+    { 1,12,19},
+    { 1,13,19},
+    { 1,14,19},
+    { 1,15,20},
+    { 1,16,20},
+    { 1,17,20},
+    { 2, 9,18},
+    { 2,10,18},
+    { 2,11,18},
+    { 2,12,19},
+    { 2,13,19},
+    { 2,14,19},
+    { 2,15,20},
+    { 2,16,20},
+    { 2,17,20},
+    { 3, 9,21},
+    { 3,10,21},
+    { 3,11,21},
+    { 3,12,22},
+    { 3,13,22},
+    { 3,14,22},
+    { 3,15,23},
+    { 3,16,23},
+    { 3,17,23},
+    { 4, 9,21},
+    { 4,10,21},
+    { 4,11,21},
+    { 4,12,22},
+    { 4,13,22},
+    { 4,14,22},
+    { 4,15,23},
+    { 4,16,23},
+    { 4,17,23},
+    { 5, 9,21},
+    { 5,10,21},
+    { 5,11,21},
+    { 5,12,22},
+    { 5,13,22},
+    { 5,14,22},
+    { 5,15,23},
+    { 5,16,23},
+    { 5,17,23},
+    { 6, 9,24},
+    { 6,10,24},
+    { 6,11,24},
+    { 6,12,25},
+    { 6,13,25},
+    { 6,14,25},
+    { 6,15,26},
+    { 6,16,26},
+    { 6,17,26},
+    { 7, 9,24},
+    { 7,10,24},
+    { 7,11,24},
+    { 7,12,25},
+    { 7,13,25},
+    { 7,14,25},
+    { 7,15,26},
+    { 7,16,26},
+    { 7,17,26},
+    { 8, 9,24},
+    { 8,10,24},
+    { 8,11,24},
+    { 8,12,25},
+    { 8,13,25},
+    { 8,14,25},
+    { 8,15,26},
+    { 8,16,26},
+    { 8,17,26}
+};
+
+const uint8_t g_cellPositions[81][3] =
+{
+    {0,0,0},
+    {1,0,1},
+    {2,0,2},
+    {3,0,0},
+    {4,0,1},
+    {5,0,2},
+    {6,0,0},
+    {7,0,1},
+    {8,0,2},
+    {0,1,3},
+    {1,1,4},
+    {2,1,5},
+    {3,1,3},
+    {4,1,4},
+    {5,1,5},
+    {6,1,3},
+    {7,1,4},
+    {8,1,5},
+    {0,2,6},
+    {1,2,7},
+    {2,2,8},
+    {3,2,6},
+    {4,2,7},
+    {5,2,8},
+    {6,2,6},
+    {7,2,7},
+    {8,2,8},
+    {0,3,0},
+    {1,3,1},
+    {2,3,2},
+    {3,3,0},
+    {4,3,1},
+    {5,3,2},
+    {6,3,0},
+    {7,3,1},
+    {8,3,2},
+    {0,4,3},
+    {1,4,4},
+    {2,4,5},
+    {3,4,3},
+    {4,4,4},
+    {5,4,5},
+    {6,4,3},
+    {7,4,4},
+    {8,4,5},
+    {0,5,6},
+    {1,5,7},
+    {2,5,8},
+    {3,5,6},
+    {4,5,7},
+    {5,5,8},
+    {6,5,6},
+    {7,5,7},
+    {8,5,8},
+    {0,6,0},
+    {1,6,1},
+    {2,6,2},
+    {3,6,0},
+    {4,6,1},
+    {5,6,2},
+    {6,6,0},
+    {7,6,1},
+    {8,6,2},
+    {0,7,3},
+    {1,7,4},
+    {2,7,5},
+    {3,7,3},
+    {4,7,4},
+    {5,7,5},
+    {6,7,3},
+    {7,7,4},
+    {8,7,5},
+    {0,8,6},
+    {1,8,7},
+    {2,8,8},
+    {3,8,6},
+    {4,8,7},
+    {5,8,8},
+    {6,8,6},
+    {7,8,7},
+    {8,8,8}
+};
+
+const uint8_t g_cellPeers[81][20] =
+{
+    { 1, 2, 3, 4, 5, 6, 7, 8, 9,10,11,18,19,20,27,36,45,54,63,72},
+    { 0, 2, 3, 4, 5, 6, 7, 8, 9,10,11,18,19,20,28,37,46,55,64,73},
+    { 0, 1, 3, 4, 5, 6, 7, 8, 9,10,11,18,19,20,29,38,47,56,65,74},
+    { 0, 1, 2, 4, 5, 6, 7, 8,12,13,14,21,22,23,30,39,48,57,66,75},
+    { 0, 1, 2, 3, 5, 6, 7, 8,12,13,14,21,22,23,31,40,49,58,67,76},
+    { 0, 1, 2, 3, 4, 6, 7, 8,12,13,14,21,22,23,32,41,50,59,68,77},
+    { 0, 1, 2, 3, 4, 5, 7, 8,15,16,17,24,25,26,33,42,51,60,69,78},
+    { 0, 1, 2, 3, 4, 5, 6, 8,15,16,17,24,25,26,34,43,52,61,70,79},
+    { 0, 1, 2, 3, 4, 5, 6, 7,15,16,17,24,25,26,35,44,53,62,71,80},
+    { 0, 1, 2,10,11,12,13,14,15,16,17,18,19,20,27,36,45,54,63,72},
+    { 0, 1, 2, 9,11,12,13,14,15,16,17,18,19,20,28,37,46,55,64,73},
+    { 0, 1, 2, 9,10,12,13,14,15,16,17,18,19,20,29,38,47,56,65,74},
+    { 3, 4, 5, 9,10,11,13,14,15,16,17,21,22,23,30,39,48,57,66,75},
+    { 3, 4, 5, 9,10,11,12,14,15,16,17,21,22,23,31,40,49,58,67,76},
+    { 3, 4, 5, 9,10,11,12,13,15,16,17,21,22,23,32,41,50,59,68,77},
+    { 6, 7, 8, 9,10,11,12,13,14,16,17,24,25,26,33,42,51,60,69,78},
+    { 6, 7, 8, 9,10,11,12,13,14,15,17,24,25,26,34,43,52,61,70,79},
+    { 6, 7, 8, 9,10,11,12,13,14,15,16,24,25,26,35,44,53,62,71,80},
+    { 0, 1, 2, 9,10,11,19,20,21,22,23,24,25,26,27,36,45,54,63,72},
+    { 0, 1, 2, 9,10,11,18,20,21,22,23,24,25,26,28,37,46,55,64,73},
+    { 0, 1, 2, 9,10,11,18,19,21,22,23,24,25,26,29,38,47,56,65,74},
+    { 3, 4, 5,12,13,14,18,19,20,22,23,24,25,26,30,39,48,57,66,75},
+    { 3, 4, 5,12,13,14,18,19,20,21,23,24,25,26,31,40,49,58,67,76},
+    { 3, 4, 5,12,13,14,18,19,20,21,22,24,25,26,32,41,50,59,68,77},
+    { 6, 7, 8,15,16,17,18,19,20,21,22,23,25,26,33,42,51,60,69,78},
+    { 6, 7, 8,15,16,17,18,19,20,21,22,23,24,26,34,43,52,61,70,79},
+    { 6, 7, 8,15,16,17,18,19,20,21,22,23,24,25,35,44,53,62,71,80},
+    { 0, 9,18,28,29,30,31,32,33,34,35,36,37,38,45,46,47,54,63,72},
+    { 1,10,19,27,29,30,31,32,33,34,35,36,37,38,45,46,47,55,64,73},
+    { 2,11,20,27,28,30,31,32,33,34,35,36,37,38,45,46,47,56,65,74},
+    { 3,12,21,27,28,29,31,32,33,34,35,39,40,41,48,49,50,57,66,75},
+    { 4,13,22,27,28,29,30,32,33,34,35,39,40,41,48,49,50,58,67,76},
+    { 5,14,23,27,28,29,30,31,33,34,35,39,40,41,48,49,50,59,68,77},
+    { 6,15,24,27,28,29,30,31,32,34,35,42,43,44,51,52,53,60,69,78},
+    { 7,16,25,27,28,29,30,31,32,33,35,42,43,44,51,52,53,61,70,79},
+    { 8,17,26,27,28,29,30,31,32,33,34,42,43,44,51,52,53,62,71,80},
+    { 0, 9,18,27,28,29,37,38,39,40,41,42,43,44,45,46,47,54,63,72},
+    { 1,10,19,27,28,29,36,38,39,40,41,42,43,44,45,46,47,55,64,73},
+    { 2,11,20,27,28,29,36,37,39,40,41,42,43,44,45,46,47,56,65,74},
+    { 3,12,21,30,31,32,36,37,38,40,41,42,43,44,48,49,50,57,66,75},
+    { 4,13,22,30,31,32,36,37,38,39,41,42,43,44,48,49,50,58,67,76},
+    { 5,14,23,30,31,32,36,37,38,39,40,42,43,44,48,49,50,59,68,77},
+    { 6,15,24,33,34,35,36,37,38,39,40,41,43,44,51,52,53,60,69,78},
+    { 7,16,25,33,34,35,36,37,38,39,40,41,42,44,51,52,53,61,70,79},
+    { 8,17,26,33,34,35,36,37,38,39,40,41,42,43,51,52,53,62,71,80},
+    { 0, 9,18,27,28,29,36,37,38,46,47,48,49,50,51,52,53,54,63,72},
+    { 1,10,19,27,28,29,36,37,38,45,47,48,49,50,51,52,53,55,64,73},
+    { 2,11,20,27,28,29,36,37,38,45,46,48,49,50,51,52,53,56,65,74},
+    { 3,12,21,30,31,32,39,40,41,45,46,47,49,50,51,52,53,57,66,75},
+    { 4,13,22,30,31,32,39,40,41,45,46,47,48,50,51,52,53,58,67,76},
+    { 5,14,23,30,31,32,39,40,41,45,46,47,48,49,51,52,53,59,68,77},
+    { 6,15,24,33,34,35,42,43,44,45,46,47,48,49,50,52,53,60,69,78},
+    { 7,16,25,33,34,35,42,43,44,45,46,47,48,49,50,51,53,61,70,79},
+    { 8,17,26,33,34,35,42,43,44,45,46,47,48,49,50,51,52,62,71,80},
+    { 0, 9,18,27,36,45,55,56,57,58,59,60,61,62,63,64,65,72,73,74},
+    { 1,10,19,28,37,46,54,56,57,58,59,60,61,62,63,64,65,72,73,74},
+    { 2,11,20,29,38,47,54,55,57,58,59,60,61,62,63,64,65,72,73,74},
+    { 3,12,21,30,39,48,54,55,56,58,59,60,61,62,66,67,68,75,76,77},
+    { 4,13,22,31,40,49,54,55,56,57,59,60,61,62,66,67,68,75,76,77},
+    { 5,14,23,32,41,50,54,55,56,57,58,60,61,62,66,67,68,75,76,77},
+    { 6,15,24,33,42,51,54,55,56,57,58,59,61,62,69,70,71,78,79,80},
+    { 7,16,25,34,43,52,54,55,56,57,58,59,60,62,69,70,71,78,79,80},
+    { 8,17,26,35,44,53,54,55,56,57,58,59,60,61,69,70,71,78,79,80},
+    { 0, 9,18,27,36,45,54,55,56,64,65,66,67,68,69,70,71,72,73,74},
+    { 1,10,19,28,37,46,54,55,56,63,65,66,67,68,69,70,71,72,73,74},
+    { 2,11,20,29,38,47,54,55,56,63,64,66,67,68,69,70,71,72,73,74},
+    { 3,12,21,30,39,48,57,58,59,63,64,65,67,68,69,70,71,75,76,77},
+    { 4,13,22,31,40,49,57,58,59,63,64,65,66,68,69,70,71,75,76,77},
+    { 5,14,23,32,41,50,57,58,59,63,64,65,66,67,69,70,71,75,76,77},
+    { 6,15,24,33,42,51,60,61,62,63,64,65,66,67,68,70,71,78,79,80},
+    { 7,16,25,34,43,52,60,61,62,63,64,65,66,67,68,69,71,78,79,80},
+    { 8,17,26,35,44,53,60,61,62,63,64,65,66,67,68,69,70,78,79,80},
+    { 0, 9,18,27,36,45,54,55,56,63,64,65,73,74,75,76,77,78,79,80},
+    { 1,10,19,28,37,46,54,55,56,63,64,65,72,74,75,76,77,78,79,80},
+    { 2,11,20,29,38,47,54,55,56,63,64,65,72,73,75,76,77,78,79,80},
+    { 3,12,21,30,39,48,57,58,59,66,67,68,72,73,74,76,77,78,79,80},
+    { 4,13,22,31,40,49,57,58,59,66,67,68,72,73,74,75,77,78,79,80},
+    { 5,14,23,32,41,50,57,58,59,66,67,68,72,73,74,75,76,78,79,80},
+    { 6,15,24,33,42,51,60,61,62,69,70,71,72,73,74,75,76,77,79,80},
+    { 7,16,25,34,43,52,60,61,62,69,70,71,72,73,74,75,76,77,78,80},
+    { 8,17,26,35,44,53,60,61,62,69,70,71,72,73,74,75,76,77,78,79}
+};
+
+const uint8_t g_intersectionCells[INTERSECTION_COUNT][15] =
+{
+    // rows
+    { 0, 1, 2,   3, 4, 5, 6, 7, 8,   9,10,11,18,19,20},
+    { 3, 4, 5,   0, 1, 2, 6, 7, 8,  12,13,14,21,22,23},
+    { 6, 7, 8,   0, 1, 2, 3, 4, 5,  15,16,17,24,25,26},
+    { 9,10,11,  12,13,14,15,16,17,   0, 1, 2,18,19,20},
+    {12,13,14,   9,10,11,15,16,17,   3, 4, 5,21,22,23},
+    {15,16,17,   9,10,11,12,13,14,   6, 7, 8,24,25,26},
+    {18,19,20,  21,22,23,24,25,26,   0, 1, 2, 9,10,11},
+    {21,22,23,  18,19,20,24,25,26,   3, 4, 5,12,13,14},
+    {24,25,26,  18,19,20,21,22,23,   6, 7, 8,15,16,17},
+    {27,28,29,  30,31,32,33,34,35,  36,37,38,45,46,47},
+    {30,31,32,  27,28,29,33,34,35,  39,40,41,48,49,50},
+    {33,34,35,  27,28,29,30,31,32,  42,43,44,51,52,53},
+    {36,37,38,  39,40,41,42,43,44,  27,28,29,45,46,47},
+    {39,40,41,  36,37,38,42,43,44,  30,31,32,48,49,50},
+    {42,43,44,  36,37,38,39,40,41,  33,34,35,51,52,53},
+    {45,46,47,  48,49,50,51,52,53,  27,28,29,36,37,38},
+    {48,49,50,  45,46,47,51,52,53,  30,31,32,39,40,41},
+    {51,52,53,  45,46,47,48,49,50,  33,34,35,42,43,44},
+    {54,55,56,  57,58,59,60,61,62,  63,64,65,72,73,74},
+    {57,58,59,  54,55,56,60,61,62,  66,67,68,75,76,77},
+    {60,61,62,  54,55,56,57,58,59,  69,70,71,78,79,80},
+    {63,64,65,  66,67,68,69,70,71,  54,55,56,72,73,74},
+    {66,67,68,  63,64,65,69,70,71,  57,58,59,75,76,77},
+    {69,70,71,  63,64,65,66,67,68,  60,61,62,78,79,80},
+    {72,73,74,  75,76,77,78,79,80,  54,55,56,63,64,65},
+    {75,76,77,  72,73,74,78,79,80,  57,58,59,66,67,68},
+    {78,79,80,  72,73,74,75,76,77,  60,61,62,69,70,71},
+    // columns
+    { 0, 9,18,  27,36,45,54,63,72,   1, 2,10,11,19,20},
+    {27,36,45,   0, 9,18,54,63,72,  28,29,37,38,46,47},
+    {54,63,72,   0, 9,18,27,36,45,  55,56,64,65,73,74},
+    { 1,10,19,  28,37,46,55,64,73,   0, 2, 9,11,18,20},
+    {28,37,46,   1,10,19,55,64,73,  27,29,36,38,45,47},
+    {55,64,73,   1,10,19,28,37,46,  54,56,63,65,72,74},
+    { 2,11,20,  29,38,47,56,65,74,   0, 1, 9,10,18,19},
+    {29,38,47,   2,11,20,56,65,74,  27,28,36,37,45,46},
+    {56,65,74,   2,11,20,29,38,47,  54,55,63,64,72,73},
+    { 3,12,21,  30,39,48,57,66,75,   4, 5,13,14,22,23},
+    {30,39,48,   3,12,21,57,66,75,  31,32,40,41,49,50},
+    {57,66,75,   3,12,21,30,39,48,  58,59,67,68,76,77},
+    { 4,13,22,  31,40,49,58,67,76,   3, 5,12,14,21,23},
+    {31,40,49,   4,13,22,58,67,76,  30,32,39,41,48,50},
+    {58,67,76,   4,13,22,31,40,49,  57,59,66,68,75,77},
+    { 5,14,23,  32,41,50,59,68,77,   3, 4,12,13,21,22},
+    {32,41,50,   5,14,23,59,68,77,  30,31,39,40,48,49},
+    {59,68,77,   5,14,23,32,41,50,  57,58,66,67,75,76},
+    { 6,15,24,  33,42,51,60,69,78,   7, 8,16,17,25,26},
+    {33,42,51,   6,15,24,60,69,78,  34,35,43,44,52,53},
+    {60,69,78,   6,15,24,33,42,51,  61,62,70,71,79,80},
+    { 7,16,25,  34,43,52,61,70,79,   6, 8,15,17,24,26},
+    {34,43,52,   7,16,25,61,70,79,  33,35,42,44,51,53},
+    {61,70,79,   7,16,25,34,43,52,  60,62,69,71,78,80},
+    { 8,17,26,  35,44,53,62,71,80,   6, 7,15,16,24,25},
+    {35,44,53,   8,17,26,62,71,80,  33,34,42,43,51,52},
+    {62,71,80,   8,17,26,35,44,53,  60,61,69,70,78,79}
+};
+
+const uint16_t g_positionGroups[POSITION_GROUP_COUNT] =
+{
+    // 2 positions (36 groups)
+    0x003, 0x005, 0x006, 0x009, 0x00a, 0x00c, 0x011, 0x012, 0x014,
+    0x018, 0x021, 0x022, 0x024, 0x028, 0x030, 0x041, 0x042, 0x044,
+    0x048, 0x050, 0x060, 0x081, 0x082, 0x084, 0x088, 0x090, 0x0a0,
+    0x0c0, 0x101, 0x102, 0x104, 0x108, 0x110, 0x120, 0x140, 0x180,
+    // 3 positions (84 groups)
+    0x007, 0x00b, 0x00d, 0x00e, 0x013, 0x015, 0x016, 0x019, 0x01a,
+    0x01c, 0x023, 0x025, 0x026, 0x029, 0x02a, 0x02c, 0x031, 0x032,
+    0x034, 0x038, 0x043, 0x045, 0x046, 0x049, 0x04a, 0x04c, 0x051,
+    0x052, 0x054, 0x058, 0x061, 0x062, 0x064, 0x068, 0x070, 0x083,
+    0x085, 0x086, 0x089, 0x08a, 0x08c, 0x091, 0x092, 0x094, 0x098,
+    0x0a1, 0x0a2, 0x0a4, 0x0a8, 0x0b0, 0x0c1, 0x0c2, 0x0c4, 0x0c8,
+    0x0d0, 0x0e0, 0x103, 0x105, 0x106, 0x109, 0x10a, 0x10c, 0x111,
+    0x112, 0x114, 0x118, 0x121, 0x122, 0x124, 0x128, 0x130, 0x141,
+    0x142, 0x144, 0x148, 0x150, 0x160, 0x181, 0x182, 0x184, 0x188,
+    0x190, 0x1a0, 0x1c0,
+    // 4 positions (126 groups)
+    0x00f, 0x017, 0x01b, 0x01d, 0x01e, 0x027, 0x02b, 0x02d, 0x02e,
+    0x033, 0x035, 0x036, 0x039, 0x03a, 0x03c, 0x047, 0x04b, 0x04d,
+    0x04e, 0x053, 0x055, 0x056, 0x059, 0x05a, 0x05c, 0x063, 0x065,
+    0x066, 0x069, 0x06a, 0x06c, 0x071, 0x072, 0x074, 0x078, 0x087,
+    0x08b, 0x08d, 0x08e, 0x093, 0x095, 0x096, 0x099, 0x09a, 0x09c,
+    0x0a3, 0x0a5, 0x0a6, 0x0a9, 0x0aa, 0x0ac, 0x0b1, 0x0b2, 0x0b4,
+    0x0b8, 0x0c3, 0x0c5, 0x0c6, 0x0c9, 0x0ca, 0x0cc, 0x0d1, 0x0d2,
+    0x0d4, 0x0d8, 0x0e1, 0x0e2, 0x0e4, 0x0e8, 0x0f0, 0x107, 0x10b,
+    0x10d, 0x10e, 0x113, 0x115, 0x116, 0x119, 0x11a, 0x11c, 0x123,
+    0x125, 0x126, 0x129, 0x12a, 0x12c, 0x131, 0x132, 0x134, 0x138,
+    0x143, 0x145, 0x146, 0x149, 0x14a, 0x14c, 0x151, 0x152, 0x154,
+    0x158, 0x161, 0x162, 0x164, 0x168, 0x170, 0x183, 0x185, 0x186,
+    0x189, 0x18a, 0x18c, 0x191, 0x192, 0x194, 0x198, 0x1a1, 0x1a2,
+    0x1a4, 0x1a8, 0x1b0, 0x1c1, 0x1c2, 0x1c4, 0x1c8, 0x1d0, 0x1e0
+};
+
+const int g_positionGroupStart[6] = { 0, 0, 0, 36, 120, POSITION_GROUP_COUNT };
+
+
+BoardCore::BoardCore()
+{
+    Clear();
+}
+
+void BoardCore::Reset()
+{
+    // one block copy of an empty board is cheaper than filling in the tables entry by entry
+    static const BoardCore s_empty;
+
+    *this = s_empty;
+}
+
+void BoardCore::Clear()
+{
+    for (int index = 0; index < 81; index++)
+    {
+        masks[index] = CELLINIT;
+        values[index] = 0;
+    }
+
+    for (int index = 0; index < 27; index++)
+    {
+        placed[index] = 0;
+        placedcount[index] = 0;
+
+        for (int value = 0; value < 9; value++)
+        {
+            positions[index][value] = CELLINIT;
+        }
+    }
+
+    for (int index = 0; index < 9; index++)
+    {
+        for (int setindex = 0; setindex < 32; setindex++)
+        {
+            setmasks[index][setindex] = (setindex < 27) ? CELLINIT : 0;
+        }
+    }
+
+    unsolved = 81;
+    conflicts = 0;
+    contradictions = 0;
+}
+
+void BoardCore::SetCell(int cellindex, int value, uint16_t mask)
+{
+    int oldvalue = values[cellindex];
+
+    SetMask(cellindex, mask);
+    values[cellindex] = (uint8_t)value;
+
+    if (oldvalue == value)
+        return;
+
+    unsolved += (oldvalue == 0) ? -1 : ((value == 0) ? 1 : 0);
+
+    for (int x = 0; x < 3; x++)
+    {
+        int setindex = g_cellSets[cellindex][x];
+
+        if (oldvalue != 0)
+        {
+            // a value is being replaced, rebuild the placed mask from the cells of the set
+            RebuildPlaced(setindex);
+        }
+        else
+        {
+            uint16_t wValue = (uint16_t)(0x01 << (value - 1));
+
+            if (placed[setindex] & wValue)
+            {
+                conflicts++;
+            }
+            placed[setindex] |= wValue;
+            placedcount[setindex]++;
+        }
+    }
+}
+
+void BoardCore::RestoreCell(int cellindex, int value, uint16_t mask, uint32_t& dirtysets)
+{
+    int oldvalue = values[cellindex];
+
+    SetMask(cellindex, mask);
+    values[cellindex] = (uint8_t)value;
+
+    if (oldvalue == value)
+        return;
+
+    unsolved += (oldvalue == 0) ? -1 : ((value == 0) ? 1 : 0);
+
+    for (int x = 0; x < 3; x++)
+    {
+        dirtysets |= (0x01 << g_cellSets[cellindex][x]);
+    }
+}
+
+void BoardCore::SetMask(int cellindex, uint16_t mask)
+{
+    uint16_t wChanged = masks[cellindex] ^ mask;
+
+    if (wChanged == 0)
+        return;
+
+    if ((masks[cellindex] == 0) != (mask == 0))
+    {
+        contradictions += (mask == 0) ? 1 : -1;
+    }
+
+    masks[cellindex] = mask;
+
+    for (int x = 0; x < 3; x++)
+    {
+        int setindex = g_cellSets[cellindex][x];
+        uint16_t wPosition = (uint16_t)(0x01 << g_cellPositions[cellindex][x]);
+
+        setmasks[g_cellPositions[cellindex][x]][setindex] = mask;
+
+        for (int index : BitIndexes(wChanged))
+        {
+            uint16_t& wPositions = positions[setindex][index];
+
+            if (wPositions == wPosition)
+            {
+                contradictions++;  // the last place for the value is going away
+            }
+            else if (wPositions == 0)
+            {
+                contradictions--;  // a value that had no place gets one
+            }
+            wPositions ^= wPosition;
+        }
+    }
+}
+
+void BoardCore::RebuildPlaced(int setindex)
+{
+    conflicts -= placedcount[setindex] - PopCount(placed[setindex]);
+
+    placed[setindex] = 0;
+    placedcount[setindex] = 0;
+    for (int index = 0; index < 9; index++)
+    {
+        int setvalue = values[g_setCells[setindex][index]];
+        if (setvalue != 0)
+        {
+            placed[setindex] |= (0x01 << (setvalue - 1));
+            placedcount[setindex]++;
+        }
+    }
+
+    conflicts += placedcount[setindex] - PopCount(placed[setindex]);
+}
+
+bool BoardCore::IsEqual(const BoardCore& other) const
+{
+    return ((memcmp(masks, other.masks, sizeof(masks)) == 0) &&
+            (memcmp(values, other.values, sizeof(values)) == 0) &&
+            (memcmp(placed, other.placed, sizeof(placed)) == 0) &&
+            (memcmp(placedcount, other.placedcount, sizeof(placedcount)) == 0) &&
+            (memcmp(positions, other.positions, sizeof(positions)) == 0) &&
+            (memcmp(setmasks, other.setmasks, sizeof(setmasks)) == 0) &&
+            (unsolved == other.unsolved) &&
+            (conflicts == other.conflicts) &&
+            (contradictions == other.contradictions));
+}
@@ -0,0 +1,88 @@
+/*
+    Copyright 2017 John Selbie
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef SUDOKU_BOARD_CORE_H
+#define SUDOKU_BOARD_CORE_H
+
+// Cells are numbered 0-80 the same way as Cell::_cellIndex (row * 9 + column).
+// Sets are numbered 0-26: rows 0-8, then columns 9-17, then squares 18-26.
+
+const int SET_ROW_BASE = 0;
+const int SET_COLUMN_BASE = 9;
+const int SET_SQUARE_BASE = 18;
+
+extern const uint8_t g_setCells[27][9];     // the 9 cells of each set, in the same order as CellSet::_set
+extern const uint8_t g_cellSets[81][3];     // the row, column, and square set of each cell
+extern const uint8_t g_cellPositions[81][3]; // the index of each cell within its row, column, and square set
+extern const uint8_t g_cellPeers[81][20];   // the 20 other cells that share a set with each cell
+
+// The 54 places where a row or column crosses a square.  Intersections 0-26 are the rows and 27-53 the columns, three per
+// line from left to right (top to bottom).  g_intersectionCells lists the 3 cells the line and square share, then the
+// other 6 cells of the line, then the other 6 cells of the square.
+const int INTERSECTION_COUNT = 54;
+extern const uint8_t g_intersectionCells[INTERSECTION_COUNT][15];
+
+// Every group of 2, 3, or 4 of the 9 positions in a set, as a position mask (bit N is index N of the set), sorted by
+// group size.  The groups of size N are g_positionGroups[g_positionGroupStart[N]] up to g_positionGroupStart[N + 1].
+// Within a size the masks are in increasing order, so the groups that only use the first M positions come first.
+const int POSITION_GROUP_COUNT = 36 + 84 + 126;
+extern const uint16_t g_positionGroups[POSITION_GROUP_COUNT];
+extern const int g_positionGroupStart[6];
+
+// BoardCore is a flat copy of the mutable state of a board.  The candidate masks and values of all 81 cells are stored
+// contiguously, so they fit in a few cache lines and the static tables above replace the Cell and CellSet pointers.
+// SudokuBoard keeps its BoardCore in sync with the Cell objects so that solving algorithms can move over to it one at a time.
+struct BoardCore
+{
+    uint16_t masks[81];              // candidate list of each cell, same bit layout as Cell::_bitmask
+    uint8_t values[81];              // value of each cell (1-9), 0 means unsolved
+    uint16_t placed[27];             // bitmask of the values placed in each set
+    uint8_t placedcount[27];         // number of cells with a value in each set
+
+    // positions[setindex][value - 1] has a bit for each cell of the set (bit N is index N of the set) with the value
+    // in its candidate list.  It is the same information as the masks turned around, kept in sync by SetMask
+    uint16_t positions[27][9];
+
+    // setmasks[index][setindex] is the candidate mask of cell "index" of each set: the masks turned set-major, kept in
+    // sync by SetMask, so that CountSetCandidates can load 16 sets at a time.  Lanes 27-31 are padding and always 0
+    uint16_t setmasks[9][32];
+
+    // Counters kept up to date by SetCell and SetMask, so that checking the whole board is a compare against 0.
+    // A solved cell's mask is its value, so a value with no position in a set is neither placed nor possible there.
+    int unsolved;        // cells without a value
+    int conflicts;       // values placed more than once in a set, one for every extra copy
+    int contradictions;  // cells with no candidates left plus values with no place left in a set
+
+    BoardCore();
+    void Reset();  // every cell unsolved with all candidates
+    void Clear();  // same as Reset, filling in every table instead of copying an empty board
+
+    // SetCell records a cell's new value and candidate mask (as left by Cell::SetValue)
+    void SetCell(int cellindex, int value, uint16_t mask);
+
+    // SetMask changes only the candidate mask of a cell
+    void SetMask(int cellindex, uint16_t mask);
+
+    // recomputes placed[setindex] and placedcount[setindex] from the values of the cells in the set
+    void RebuildPlaced(int setindex);
+
+    // RestoreCell puts back a cell's old value and mask without touching the placed masks.  The sets that need a
+    // RebuildPlaced afterwards are added to "dirtysets" (bit N is set N), so undoing many cells rebuilds each set once.
+    void RestoreCell(int cellindex, int value, uint16_t mask, uint32_t& dirtysets);
+
+    bool IsEqual(const BoardCore& other) const;
+};
+
+#endif
@@ -13,6 +13,7 @@
 
 #include "stdafx.h"
 #include "cell.h"
+#include "bitops.h"
 
 // Must match up to CELL_RELATIONSHIP
 const char *g_relationship_name[] = {
@@ -101,113 +102,36 @@ bool Cell::ClearValueFromMask(int value)
     return true;
 }
 
-bool Cell::ClearBitmaskFromMask(uint16_t mask)
-{
-    assert(mask != 0);
-
-    assert((mask & ~CELLINIT) == 0);
-
-    if (mask == 0)
-        return false;
-
-    mask = mask & CELLINIT;
-
-    uint16_t newMask = _bitmask & ~mask;
-
-    if (newMask == _bitmask)
-    {
-        return false;
-    }
-
-    _bitmask = newMask;
-
-    return true;
-}
-
 
 //static
 int Cell::BitCount(uint16_t w)
 {
-/*
-    0000 -> 0
-    0001 -> 1
-    0010 -> 1
-    0011 -> 2
-
-    0100 -> 1
-    0101 -> 2
-    0110 -> 2
-    0111 -> 3
-
-    1000 -> 1
-    1001 -> 2
-    1010 -> 2
-    1011 -> 3
-
-    1100 -> 2
-    1101 -> 3
-    1110 -> 3
-    1111 -> 4 
-*/
-
-    int bitcount[16] = {0,1,1,2, 1,2,2,3, 1,2,2,3, 2,3,3,4};
-    int count = 0;
-
-    for (int index = 0; index < 4; index++)
-    {
-        uint16_t mask = w & 0x000f;
-        count += bitcount[mask];
-        w = w >> 4;
-    }
-
-    return count;
+    return PopCount(w);
 }
 
 
 //static
 int Cell::GetCellValueFromBitmask(uint16_t mask)
 {
-    int value = 1;
-
-    if (BitCount(mask) != 1)
+    if (PopCount(mask) != 1)
     {
         assert(false);
         return 0;
     }
 
-    while (mask)
-    {
-        if (mask & 0x01)
-        {
-            return value;
-        }
-        value++;
-        mask = mask >> 0x01;
-    }
-    return value;
+    return LowestBitIndex(mask) + 1;
 }
 
 
 //static
 int Cell::GetCellValueFromBitmaskAndClear(uint16_t &mask)
 {
-    unsigned int value = 0;
-
     if (mask == 0)
         return 0;
 
-    while (mask)
-    {
-        value++;
-
-        if (mask & (0x01 << (value-1)))
-        {
-            mask = mask & ~(0x01 << (value-1));
-            return value;
-        }
-    }
-
-    return 0;
+    int value = LowestBitIndex(mask) + 1;
+    mask = (uint16_t)ClearLowestBit(mask);
+    return value;
 }
 
 CELL_RELATIONSHIP Cell::GetRelationship(CellSet *cellset)
@@ -54,7 +54,6 @@ struct Cell
     void Reset(); // sets everything back to initialization values (value = 0, _bitmask = CELLINIT, etc..)
     bool IsOkToSetValue(int value);     // returns true if "value" is in this cell's candidate list
     bool ClearValueFromMask(int value); // removes a value from this cell's candidate list
-    bool ClearBitmaskFromMask(uint16_t mask); // removes an entire bitmask from the the cell's candidate list
 
     // BitCount is a utility function that returns the number of bits set in w
     static int BitCount(uint16_t w);
@@ -0,0 +1,467 @@
+/*
+    Copyright 2017 John Selbie
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "stdafx.h"
+#include "dlxsolver.h"
+
+// index of the first node of each row in the pool
+const int DLX_FIRST_ROW_NODE = 1 + DLX_COLUMNS;
+
+// DlxTemplate holds the links for the full exact cover matrix with nothing covered.  It is built once
+// and copied into a solver every time a puzzle is loaded.
+struct DlxTemplate
+{
+    DlxNode nodes[DLX_NODES];
+    int columnsize[1 + DLX_COLUMNS];
+
+    DlxTemplate();
+};
+
+DlxTemplate::DlxTemplate()
+{
+    // node 0 is the root and nodes 1-324 are the column headers, all linked in a circle
+    for (int index = 0; index <= DLX_COLUMNS; index++)
+    {
+        nodes[index].left = (index == 0) ? DLX_COLUMNS : (index - 1);
+        nodes[index].right = (index == DLX_COLUMNS) ? 0 : (index + 1);
+        nodes[index].up = index;
+        nodes[index].down = index;
+        nodes[index].column = index;
+        nodes[index].row = -1;
+        columnsize[index] = 0;
+    }
+
+    int node = DLX_FIRST_ROW_NODE;
+
+    for (int cellindex = 0; cellindex < 81; cellindex++)
+    {
+        int row = cellindex / 9;
+        int col = cellindex % 9;
+        int square = 3*(row/3) + (col/3);
+
+        for (int valueindex = 0; valueindex < 9; valueindex++)
+        {
+            // the 4 constraints this choice covers: the cell, then the value in the row, column, and square
+            int columns[4];
+            columns[0] = 1 + cellindex;
+            columns[1] = 1 + 81 + (row * 9) + valueindex;
+            columns[2] = 1 + 162 + (col * 9) + valueindex;
+            columns[3] = 1 + 243 + (square * 9) + valueindex;
+
+            for (int x = 0; x < 4; x++)
+            {
+                DlxNode& n = nodes[node + x];
+                int column = columns[x];
+
+                n.column = column;
+                n.row = (cellindex * 9) + valueindex;
+                n.left = node + ((x + 3) % 4);
+                n.right = node + ((x + 1) % 4);
+
+                // append to the bottom of the column
+                n.down = column;
+                n.up = nodes[column].up;
+                nodes[n.up].down = node + x;
+                nodes[column].up = node + x;
+                columnsize[column]++;
+            }
+
+            node += 4;
+        }
+    }
+
+    assert(node == DLX_NODES);
+}
+
+static const DlxTemplate& GetDlxTemplate()
+{
+    static const DlxTemplate dlxtemplate;
+    return dlxtemplate;
+}
+
+
+DlxSolver::DlxSolver() :
+m_depth(0),
+m_fConflict(false),
+m_nodecount(0),
+m_loglevel(LOG_DUMPS)
+{
+    Reset();
+}
+
+void DlxSolver::Reset()
+{
+    const DlxTemplate& dlxtemplate = GetDlxTemplate();
+
+    memcpy(m_nodes, dlxtemplate.nodes, sizeof(m_nodes));
+    memcpy(m_columnsize, dlxtemplate.columnsize, sizeof(m_columnsize));
+    memset(m_values, 0, sizeof(m_values));
+
+    m_depth = 0;
+    m_fConflict = false;
+    m_nodecount = 0;
+}
+
+bool DlxSolver::LoadFromFile(const std::string& filename)
+{
+    std::ifstream infile(filename);
+
+    if (infile.is_open() == false)
+    {
+        SOLVER_LOG(LOG_SUMMARY, "Error processing file!");
+        return false;
+    }
+
+    // puzzle files may have notes after the grid, so stop at the 81st cell like SudokuBoard::LoadFromFile
+    std::string contents((std::istreambuf_iterator<char>(infile)), std::istreambuf_iterator<char>());
+    if (LoadCells(contents.data(), contents.size(), false) == false)
+    {
+        SOLVER_LOG(LOG_SUMMARY, "Error processing file!");
+        return false;
+    }
+
+    return true;
+}
+
+bool DlxSolver::LoadFromBuffer(const char *buffer, size_t length)
+{
+    return LoadCells(buffer, length, true);
+}
+
+bool DlxSolver::LoadCells(const char *buffer, size_t length, bool fStrict)
+{
+    int cellindex = 0;
+    size_t index;
+
+    Reset();
+
+    for (index = 0; (index < length) && (cellindex < 81); index++)
+    {
+        char c = buffer[index];
+
+        if ((c == ' ') || (c == '\t') || (c == '\r') || (c == '\n'))
+        {
+            continue;
+        }
+
+        if ((c >= '1') && (c <= '9'))
+        {
+            m_values[cellindex] = c - '0';
+            if (SelectChoice(cellindex, c - '0') == false)
+            {
+                m_fConflict = true;
+            }
+        }
+
+        cellindex++;
+    }
+
+    // no log here, in memory loads are used by callers that don't want anything written to stdout
+    if (cellindex != 81)
+    {
+        return false;
+    }
+
+    // anything but whitespace after the 81st cell means this isn't a one-puzzle buffer
+    for (; fStrict && (index < length); index++)
+    {
+        char c = buffer[index];
+
+        if ((c != ' ') && (c != '\t') && (c != '\r') && (c != '\n'))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool DlxSolver::SelectChoice(int cellindex, int value)
+{
+    int first = DLX_FIRST_ROW_NODE + (((cellindex * 9) + (value - 1)) * 4);
+
+    // if any of the constraints is already covered, another initial value has already claimed it
+    for (int x = 0; x < 4; x++)
+    {
+        int column = m_nodes[first + x].column;
+        if (m_nodes[m_nodes[column].right].left != column)
+        {
+            return false;
+        }
+    }
+
+    for (int x = 0; x < 4; x++)
+    {
+        Cover(m_nodes[first + x].column);
+    }
+
+    return true;
+}
+
+void DlxSolver::Cover(int column)
+{
+    DlxNode *nodes = m_nodes;
+
+    nodes[nodes[column].right].left = nodes[column].left;
+    nodes[nodes[column].left].right = nodes[column].right;
+
+    for (int i = nodes[column].down; i != column; i = nodes[i].down)
+    {
+        for (int j = nodes[i].right; j != i; j = nodes[j].right)
+        {
+            nodes[nodes[j].down].up = nodes[j].up;
+            nodes[nodes[j].up].down = nodes[j].down;
+            m_columnsize[nodes[j].column]--;
+        }
+    }
+}
+
+void DlxSolver::Uncover(int column)
+{
+    DlxNode *nodes = m_nodes;
+
+    for (int i = nodes[column].up; i != column; i = nodes[i].up)
+    {
+        for (int j = nodes[i].left; j != i; j = nodes[j].left)
+        {
+            m_columnsize[nodes[j].column]++;
+            nodes[nodes[j].down].up = j;
+            nodes[nodes[j].up].down = j;
+        }
+    }
+
+    nodes[nodes[column].right].left = column;
+    nodes[nodes[column].left].right = column;
+}
+
+bool DlxSolver::Search()
+{
+    DlxNode *nodes = m_nodes;
+
+    m_nodecount++;
+
+    if (nodes[0].right == 0)
+    {
+        // every constraint is covered
+        return true;
+    }
+
+    // pick the constraint with the fewest choices left
+    int column = nodes[0].right;
+    for (int c = nodes[column].right; c != 0; c = nodes[c].right)
+    {
+        if (m_columnsize[c] < m_columnsize[column])
+        {
+            column = c;
+            if (m_columnsize[c] <= 1)
+                break;
+        }
+    }
+
+    if (m_columnsize[column] == 0)
+    {
+        return false;
+    }
+
+    Cover(column);
+
+    for (int r = nodes[column].down; r != column; r = nodes[r].down)
+    {
+        m_solution[m_depth] = nodes[r].row;
+        m_depth++;
+
+        for (int j = nodes[r].right; j != r; j = nodes[j].right)
+        {
+            Cover(nodes[j].column);
+        }
+
+        bool fFound = Search();
+
+        for (int j = nodes[r].left; j != r; j = nodes[j].left)
+        {
+            Uncover(nodes[j].column);
+        }
+
+        if (fFound)
+        {
+            Uncover(column);
+            return true;
+        }
+
+        m_depth--;
+    }
+
+    Uncover(column);
+    return false;
+}
+
+bool DlxSolver::Solve()
+{
+    bool fSolved = false;
+
+    // a search always uncovers everything it covered, so the links are back to the loaded puzzle.  Only the
+    // partial solution of an earlier Solve has to be thrown away
+    m_depth = 0;
+    m_nodecount = 0;
+    memset(m_solution, 0, sizeof(m_solution));
+
+    if (SOLVER_LOG_ENABLED(LOG_SUMMARY))
+    {
+        Log("\n");
+        Dump();
+        Log("\n");
+    }
+
+    if ((m_fConflict == false) && Search())
+    {
+        for (int index = 0; index < m_depth; index++)
+        {
+            int row = m_solution[index];
+            m_values[row / 9] = (row % 9) + 1;
+        }
+        fSolved = true;
+
+        if (SOLVER_LOG_ENABLED(LOG_SUMMARY))
+        {
+            Log("\n");
+            Dump();
+            Log("\n");
+        }
+    }
+
+    SOLVER_LOG(LOG_SUMMARY, "Number of search nodes - %llu", (unsigned long long)m_nodecount);
+    if (fSolved)
+    {
+        SOLVER_LOG(LOG_SUMMARY, "Board has been solved");
+    }
+    else
+    {
+        SOLVER_LOG(LOG_SUMMARY, "Board has not been solved");
+        SOLVER_LOG(LOG_SUMMARY, "");
+    }
+
+    bool fValid = IsValid();
+    SOLVER_LOG(LOG_SUMMARY, "%sBoard is%s valid", fValid?"":"WARNING - ", fValid?"":" NOT");
+
+    return fSolved;
+}
+
+bool DlxSolver::IsSolved()
+{
+    for (int index = 0; index < 81; index++)
+    {
+        if (m_values[index] == 0)
+            return false;
+    }
+
+    return true;
+}
+
+bool DlxSolver::IsValid()
+{
+    // no value may appear twice in a row, column, or square
+    uint16_t rowmask[9] = {0};
+    uint16_t colmask[9] = {0};
+    uint16_t squaremask[9] = {0};
+
+    for (int index = 0; index < 81; index++)
+    {
+        int value = m_values[index];
+        if (value == 0)
+            continue;
+
+        int row = index / 9;
+        int col = index % 9;
+        int square = 3*(row/3) + (col/3);
+        uint16_t mask = 0x01 << (value - 1);
+
+        if ((rowmask[row] & mask) || (colmask[col] & mask) || (squaremask[square] & mask))
+            return false;
+
+        rowmask[row] |= mask;
+        colmask[col] |= mask;
+        squaremask[square] |= mask;
+    }
+
+    return true;
+}
+
+void DlxSolver::GetBoardLine(char *pszLine)
+{
+    for (int index = 0; index < 81; index++)
+    {
+        int value = m_values[index];
+        *pszLine++ = value ? (char)(value + '0') : '.';
+    }
+    *pszLine = '\0';
+}
+
+void DlxSolver::SetLogLevel(LOG_LEVEL level)
+{
+    m_loglevel = level;
+}
+
+void DlxSolver::Dump()
+{
+    for (int row = 0; row < 9; row++)
+    {
+        for (int col = 0; col < 9; col++)
+        {
+            int value = m_values[row * 9 + col];
+            LogWithoutLineBreak("%c ", value ? (value + '0') : '?');
+
+            if ((col % 3 == 2) && (col != 8))
+                LogWithoutLineBreak("| ");
+        }
+        Log("");
+
+        if (row % 3 == 2)
+        {
+            Log("---------------------");
+        }
+    }
+}
+
+void DlxSolver::LogWithoutLineBreak(const char *pwszFormat, ...)
+{
+    if (m_loglevel == LOG_OFF)
+        return;
+
+    va_list args;
+    va_start(args, pwszFormat);
+    char szMsg[1024];
+
+    vsnprintf(szMsg, 1024, pwszFormat, args);
+
+    std::cout << szMsg;
+
+    va_end(args);
+}
+
+void DlxSolver::Log(const char *pwszFormat, ...)
+{
+    if (m_loglevel == LOG_OFF)
+        return;
+
+    va_list args;
+    va_start(args, pwszFormat);
+    char szMsg[1024];
+
+    vsnprintf(szMsg, 1024, pwszFormat, args);
+
+    std::cout << szMsg << '\n';
+
+    va_end(args);
+}
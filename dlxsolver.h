@@ -0,0 +1,94 @@
+/*
+    Copyright 2017 John Selbie
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef SUDOKU_DLX_SOLVER_H
+#define SUDOKU_DLX_SOLVER_H
+
+#include "loglevel.h"
+
+// DlxSolver is a second, independent solving engine.  Sudoku is written as an exact cover problem and solved
+// with Knuth's Algorithm X using Dancing Links.
+//
+// There are 324 constraints (columns): every cell holds a value, and every row, column, and square holds each value once.
+// There are 729 choices (rows), one for each value in each cell, and each choice covers exactly 4 constraints.
+// All of the nodes live in one fixed pool inside the solver, and a clean copy of the links is kept so that loading
+// the next puzzle is a single copy.  Solving never allocates.
+//
+// It reads the same input as SudokuBoard and writes the same board dumps and summary lines.
+
+const int DLX_COLUMNS = 324;
+const int DLX_ROWS = 729;
+const int DLX_NODES = 1 + DLX_COLUMNS + (DLX_ROWS * 4);  // root, column headers, then 4 nodes per row
+
+// the pool has fewer than 32768 nodes, so the links are 16 bits.  That halves the copy made on every load and
+// the cache lines that Cover and Uncover walk
+struct DlxNode
+{
+    int16_t left;
+    int16_t right;
+    int16_t up;
+    int16_t down;
+    int16_t column;  // index of the column header node
+    int16_t row;     // choice index (cellindex * 9 + value - 1), -1 for the root and column headers
+};
+
+static_assert(DLX_NODES <= INT16_MAX, "DlxNode links are 16 bits");
+
+class DlxSolver
+{
+public:
+    DlxSolver();
+
+    bool LoadFromFile(const std::string& filename);
+    bool LoadFromBuffer(const char *buffer, size_t length);
+
+    bool Solve();
+
+    bool IsSolved();
+    bool IsValid();
+
+    void GetBoardLine(char *pszLine);
+    void SetLogLevel(LOG_LEVEL level);
+
+    void Dump();
+
+protected:
+    DlxNode m_nodes[DLX_NODES];
+    int m_columnsize[1 + DLX_COLUMNS];
+    int m_values[81];      // value of each cell, 0 if unsolved
+    int m_solution[81];    // choices (rows) picked by the search, in order
+    int m_depth;
+    bool m_fConflict;      // the initial values break a rule, so there is no solution
+    uint64_t m_nodecount;  // search nodes visited by the last Solve
+
+    LOG_LEVEL m_loglevel;
+
+    void Reset();
+    bool LoadCells(const char *buffer, size_t length, bool fStrict);  // fStrict rejects text after the 81st cell
+    bool SelectChoice(int cellindex, int value);  // places an initial value
+    void Cover(int column);
+    void Uncover(int column);
+    bool Search();
+
+    void LogWithoutLineBreak(const char *pszFormat, ...);
+    void Log(const char *pszFormat, ...);
+
+private:
+    // disable assignment and copy constructor
+    DlxSolver(const DlxSolver& other) {};
+    DlxSolver& operator=(const DlxSolver& other) { return *this; };
+};
+
+#endif
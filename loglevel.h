@@ -0,0 +1,41 @@
+/*
+    Copyright 2017 John Selbie
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef SUDOKU_LOG_LEVEL_H
+#define SUDOKU_LOG_LEVEL_H
+
+// Each level includes everything from the levels before it
+enum LOG_LEVEL
+{
+    LOG_OFF,       // nothing is logged
+    LOG_SUMMARY,   // the starting and final board plus the result lines (number of scans, solved, valid)
+    LOG_STEPS,     // every value placed and candidate removed by the solving algorithms
+    LOG_DUMPS      // the whole board after every scan
+};
+
+// SOLVER_LOG is used inside the solver classes in place of calling Log directly.  The level is checked before
+// the call, so when the level is off the arguments are never evaluated or formatted.  The class must have
+// a LOG_LEVEL m_loglevel member and a printf style Log method.
+// Compiling with SUDOKU_NO_LOGGING defined removes the calls altogether.  The arguments still have to compile,
+// which keeps the disabled build from rotting and from warning about variables that only exist for logging.
+#ifdef SUDOKU_NO_LOGGING
+#define SOLVER_LOG_ENABLED(level) false
+#define SOLVER_LOG(level, ...) do { if (false) { Log(__VA_ARGS__); } } while (0)
+#else
+#define SOLVER_LOG_ENABLED(level) (m_loglevel >= (level))
+#define SOLVER_LOG(level, ...) do { if (SOLVER_LOG_ENABLED(level)) { Log(__VA_ARGS__); } } while (0)
+#endif
+
+#endif
@@ -15,31 +15,236 @@
 
 #include "stdafx.h"
 #include "sudokuboard.h"
+#include "dlxsolver.h"
+#include "batchsolver.h"
 
 
-int main(int argc, char* argv[])
+int SolveSingleDlx(const char *filename, LOG_LEVEL loglevel)
+{
+    DlxSolver dlx;
+
+    dlx.SetLogLevel(loglevel);
+
+    std::cout << "Loading: " << filename << std::endl;
+    bool loadresult = dlx.LoadFromFile(filename);
+
+    if (loadresult == false)
+    {
+        std::cout << "Failed to load board from file" << std::endl;
+    }
+    else
+    {
+        dlx.Solve();
+    }
+
+    return 0;
+}
+
+int SolveSingle(const char *filename, const BatchOptions& options, LOG_LEVEL loglevel, const std::string& traceformat)
 {
     SudokuBoard board;
 
-    if (argc < 2)
+    board.SetLogLevel(loglevel);
+    board.SetTracing(traceformat.empty() == false);
+    board.SetStats(options.fStats);
+    board.SetEngine(options.engine);
+    board.SetSearchFallback(options.fSearch);
+
+    std::cout << "Loading: " << filename << std::endl;
+    bool loadresult = board.LoadFromFile(filename);
+
+    if (loadresult == false)
+    {
+        std::cout << "Failed to load board from file" << std::endl;
+    }
+    else if (options.countlimit != 0)
     {
-        std::cout << "Usage: " << argv[0] << " filename" << std::endl;
+        std::cout << "Number of solutions - " << board.CountSolutions(options.countlimit) << std::endl;
     }
     else
     {
-        std::cout << "Loading: " << argv[1] << std::endl;
-        bool loadresult = board.LoadFromFile(argv[1]);
+        board.Solve();
 
-        if (loadresult == false)
+        if (traceformat == "text")
         {
-            std::cout << "Failed to load board from file" << std::endl;
+            std::cout << board.GetTrace().FormatText();
         }
-        else
+        else if (traceformat == "json")
+        {
+            std::cout << board.GetTrace().FormatJson();
+        }
+        else if (traceformat == "replay")
+        {
+            std::cout << board.GetTrace().FormatReplay();
+        }
+
+        if (options.fStats)
         {
-            board.Solve();
+            std::cout << board.GetStats().Format();
         }
     }
 
-	return 0;
+    return 0;
 }
 
+int SolveBatch(const char *filename, const BatchOptions& options)
+{
+    BatchSolver batch(options);
+
+    std::ios::sync_with_stdio(false);
+
+    if (batch.SolveFile(filename, std::cout) == false)
+    {
+        std::cerr << "Failed to open " << filename << std::endl;
+        return 1;
+    }
+
+    const BatchStats& stats = batch.GetStats();
+
+    if (options.countlimit != 0)
+    {
+        std::cerr << "Counted " << stats.puzzles << " puzzles - " << stats.unique << " unique, " << stats.multiple << " multiple, " << stats.nosolution << " no solution";
+    }
+    else
+    {
+        std::cerr << "Solved " << stats.solved << " of " << stats.puzzles << " puzzles";
+    }
+    if (stats.errors > 0)
+    {
+        std::cerr << " (" << stats.errors << " lines were not valid puzzles)";
+    }
+    std::cerr << " in " << stats.seconds << " seconds on " << batch.GetThreadCount() << " threads - " << (uint64_t)stats.PuzzlesPerSecond() << " puzzles/sec" << std::endl;
+
+    if (options.fStats)
+    {
+        std::cerr << stats.solvestats.Format();
+    }
+
+    return 0;
+}
+
+
+int main(int argc, char* argv[])
+{
+    bool fBatch = false;
+    BatchOptions options;
+    LOG_LEVEL loglevel = LOG_DUMPS;
+    std::string traceformat;
+    const char *filename = nullptr;
+
+    for (int index = 1; index < argc; index++)
+    {
+        std::string arg = argv[index];
+
+        if (arg == "-batch")
+        {
+            fBatch = true;
+        }
+        else if (arg == "-search")
+        {
+            options.fSearch = true;
+        }
+        else if (arg == "-stats")
+        {
+            options.fStats = true;
+        }
+        else if ((arg == "-count") && (index + 1 < argc))
+        {
+            index++;
+            options.countlimit = atoi(argv[index]);
+        }
+        else if ((arg == "-threads") && (index + 1 < argc))
+        {
+            index++;
+            options.threadcount = atoi(argv[index]);
+        }
+        else if ((arg == "-log") && (index + 1 < argc))
+        {
+            index++;
+            std::string level = argv[index];
+
+            if (level == "off")
+            {
+                loglevel = LOG_OFF;
+            }
+            else if (level == "summary")
+            {
+                loglevel = LOG_SUMMARY;
+            }
+            else if (level == "steps")
+            {
+                loglevel = LOG_STEPS;
+            }
+            else if (level == "dumps")
+            {
+                loglevel = LOG_DUMPS;
+            }
+            else
+            {
+                std::cout << "Unknown log level: " << level << std::endl;
+                return 1;
+            }
+        }
+        else if ((arg == "-trace") && (index + 1 < argc))
+        {
+            index++;
+            traceformat = argv[index];
+
+            if ((traceformat != "text") && (traceformat != "json") && (traceformat != "replay"))
+            {
+                std::cout << "Unknown trace format: " << traceformat << std::endl;
+                return 1;
+            }
+        }
+        else if ((arg == "-engine") && (index + 1 < argc))
+        {
+            index++;
+            std::string engine = argv[index];
+
+            if (engine == "scan")
+            {
+                options.engine = ENGINE_SCAN;
+            }
+            else if (engine == "propagate")
+            {
+                options.engine = ENGINE_PROPAGATE;
+            }
+            else if (engine == "adaptive")
+            {
+                options.engine = ENGINE_ADAPTIVE;
+            }
+            else if (engine == "dlx")
+            {
+                options.fDancingLinks = true;
+            }
+            else
+            {
+                std::cout << "Unknown engine: " << engine << std::endl;
+                return 1;
+            }
+        }
+        else
+        {
+            filename = argv[index];
+        }
+    }
+
+    if (filename == nullptr)
+    {
+        std::cout << "Usage: " << argv[0] << " [-engine scan|propagate|adaptive|dlx] [-search] [-stats] [-count N] [-log off|summary|steps|dumps] [-trace text|json|replay] filename" << std::endl;
+        std::cout << "       " << argv[0] << " -batch [-threads N] [-engine scan|propagate|adaptive|dlx] [-search] [-stats] [-count N] filename   (one puzzle per line, use - for stdin)" << std::endl;
+        return 0;
+    }
+
+    if (fBatch)
+    {
+        return SolveBatch(filename, options);
+    }
+
+    if (options.fDancingLinks && (options.countlimit == 0))
+    {
+        return SolveSingleDlx(filename, loglevel);
+    }
+
+	return SolveSingle(filename, options, loglevel, traceformat);
+}
@@ -0,0 +1,240 @@
+/*
+    Copyright 2017 John Selbie
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "stdafx.h"
+#include "puzzlereader.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+PuzzleFile::PuzzleFile() :
+m_data(nullptr),
+m_size(0)
+#ifdef _WIN32
+,
+m_hFile(INVALID_HANDLE_VALUE),
+m_hMapping(NULL)
+#endif
+{
+}
+
+PuzzleFile::~PuzzleFile()
+{
+    Close();
+}
+
+#ifdef _WIN32
+
+bool PuzzleFile::Open(const std::string& filename)
+{
+    LARGE_INTEGER filesize;
+
+    Close();
+
+    m_hFile = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (m_hFile == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    if ((GetFileSizeEx(m_hFile, &filesize) == FALSE) || ((uint64_t)filesize.QuadPart > (uint64_t)SIZE_MAX))
+    {
+        Close();
+        return false;
+    }
+
+    m_size = (size_t)filesize.QuadPart;
+    if (m_size == 0)
+    {
+        // an empty file can't be mapped, but it is still a valid (empty) corpus
+        return true;
+    }
+
+    m_hMapping = CreateFileMappingA(m_hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (m_hMapping == NULL)
+    {
+        Close();
+        return false;
+    }
+
+    m_data = (const char*)MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0);
+    if (m_data == nullptr)
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void PuzzleFile::Close()
+{
+    if (m_data)
+    {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_hMapping != NULL)
+    {
+        CloseHandle(m_hMapping);
+    }
+    if (m_hFile != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(m_hFile);
+    }
+
+    m_data = nullptr;
+    m_size = 0;
+    m_hMapping = NULL;
+    m_hFile = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+bool PuzzleFile::Open(const std::string& filename)
+{
+    struct stat filestat;
+
+    Close();
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+        return false;
+    }
+
+    if ((fstat(fd, &filestat) != 0) || ((uint64_t)filestat.st_size > (uint64_t)SIZE_MAX))
+    {
+        close(fd);
+        return false;
+    }
+
+    m_size = (size_t)filestat.st_size;
+    if (m_size == 0)
+    {
+        // an empty file can't be mapped, but it is still a valid (empty) corpus
+        close(fd);
+        return true;
+    }
+
+    void *data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  // the mapping holds its own reference to the file
+
+    if (data == MAP_FAILED)
+    {
+        m_size = 0;
+        return false;
+    }
+
+    madvise(data, m_size, MADV_SEQUENTIAL);
+
+    m_data = (const char*)data;
+    return true;
+}
+
+void PuzzleFile::Close()
+{
+    if (m_data)
+    {
+        munmap((void*)m_data, m_size);
+    }
+
+    m_data = nullptr;
+    m_size = 0;
+}
+
+#endif
+
+const char *PuzzleFile::Begin() const
+{
+    return m_data;
+}
+
+const char *PuzzleFile::End() const
+{
+    return m_data + m_size;
+}
+
+size_t PuzzleFile::Size() const
+{
+    return m_size;
+}
+
+//static
+void PuzzleFile::SplitLines(const char *begin, const char *end, size_t rangesize, std::vector<PuzzleRange>& ranges)
+{
+    const char *pos = begin;
+
+    if (rangesize == 0)
+    {
+        rangesize = 1;
+    }
+
+    while (pos < end)
+    {
+        PuzzleRange range;
+        range.begin = pos;
+
+        if ((size_t)(end - pos) <= rangesize)
+        {
+            pos = end;
+        }
+        else
+        {
+            // move to the end of the line that the range boundary falls in
+            const char *linebreak = (const char*)memchr(pos + rangesize - 1, '\n', end - (pos + rangesize - 1));
+            pos = linebreak ? (linebreak + 1) : end;
+        }
+
+        range.end = pos;
+        ranges.push_back(range);
+    }
+}
+
+//static
+bool PuzzleFile::NextRecord(const char *&pos, const char *end, const char *&record, size_t &length)
+{
+    while (pos < end)
+    {
+        const char *linebreak = (const char*)memchr(pos, '\n', end - pos);
+        const char *lineend = linebreak ? linebreak : end;
+        const char *line = pos;
+
+        pos = linebreak ? (linebreak + 1) : end;
+
+        // skip leading whitespace to see if this is a blank or comment line
+        const char *first = line;
+        while ((first < lineend) && ((*first == ' ') || (*first == '\t') || (*first == '\r')))
+        {
+            first++;
+        }
+
+        if ((first == lineend) || (*first == '#'))
+        {
+            continue;
+        }
+
+        record = line;
+        length = lineend - line;
+        return true;
+    }
+
+    return false;
+}
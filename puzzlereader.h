@@ -0,0 +1,64 @@
+/*
+    Copyright 2017 John Selbie
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef SUDOKU_PUZZLE_READER_H
+#define SUDOKU_PUZZLE_READER_H
+
+// A PuzzleRange is a run of whole lines of puzzle text [begin, end)
+struct PuzzleRange
+{
+    const char *begin;
+    const char *end;
+};
+
+// PuzzleFile memory maps a corpus file of one puzzle per line.  Puzzle records are handed out as pointers
+// into the mapping, so reading a puzzle never allocates or copies.  The mapping stays valid until Close is called.
+class PuzzleFile
+{
+public:
+    PuzzleFile();
+    ~PuzzleFile();
+
+    bool Open(const std::string& filename);
+    void Close();
+
+    const char *Begin() const;
+    const char *End() const;
+    size_t Size() const;
+
+    // SplitLines appends ranges of about "rangesize" bytes covering [begin, end) to "ranges".
+    // Every range ends just after a line break (or at "end") so that no line is split across two ranges.
+    static void SplitLines(const char *begin, const char *end, size_t rangesize, std::vector<PuzzleRange>& ranges);
+
+    // NextRecord finds the next puzzle line at or after "pos" and advances "pos" past it.
+    // Blank lines and lines starting with '#' are skipped.  The record does not include the line break.
+    // Returns false once there are no more puzzle lines before "end".
+    static bool NextRecord(const char *&pos, const char *end, const char *&record, size_t &length);
+
+private:
+    const char *m_data;
+    size_t m_size;
+
+#ifdef _WIN32
+    void *m_hFile;
+    void *m_hMapping;
+#endif
+
+    // disable assignment and copy constructor
+    PuzzleFile(const PuzzleFile& other) {};
+    PuzzleFile& operator=(const PuzzleFile& other) { return *this; };
+};
+
+#endif
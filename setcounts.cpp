@@ -0,0 +1,135 @@
+/*
+    Copyright 2017 John Selbie
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "stdafx.h"
+#include "setcounts.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SUDOKU_AVX2_KERNEL
+#define SUDOKU_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define SUDOKU_AVX2_KERNEL
+#define SUDOKU_TARGET_AVX2
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+void CountSetCandidatesScalar(const BoardCore& core, SetCandidateCounts& counts)
+{
+    for (int setindex = 0; setindex < 27; setindex++)
+    {
+        uint16_t wOnce = 0;
+        uint16_t wTwice = 0;
+
+        for (int index = 0; index < 9; index++)
+        {
+            uint16_t wMask = core.setmasks[index][setindex];
+            wTwice |= (wOnce & wMask);
+            wOnce |= wMask;
+        }
+
+        counts.once[setindex] = wOnce;
+        counts.twice[setindex] = wTwice;
+    }
+}
+
+#ifdef SUDOKU_AVX2_KERNEL
+
+// The 27 sets are laid out as 16 bit lanes across two 256 bit registers (lanes 27-31 are unused).
+// core.setmasks[k] holds the k'th cell of each set in that layout, so each step of the loop loads one cell of all
+// 27 sets straight from the core and folds it in.
+SUDOKU_TARGET_AVX2
+void CountSetCandidatesAVX2(const BoardCore& core, SetCandidateCounts& counts)
+{
+    uint16_t once[32];
+    uint16_t twice[32];
+
+    __m256i once0 = _mm256_setzero_si256();
+    __m256i once1 = _mm256_setzero_si256();
+    __m256i twice0 = _mm256_setzero_si256();
+    __m256i twice1 = _mm256_setzero_si256();
+
+    for (int index = 0; index < 9; index++)
+    {
+        __m256i mask0 = _mm256_loadu_si256((const __m256i*)&core.setmasks[index][0]);
+        __m256i mask1 = _mm256_loadu_si256((const __m256i*)&core.setmasks[index][16]);
+
+        twice0 = _mm256_or_si256(twice0, _mm256_and_si256(once0, mask0));
+        twice1 = _mm256_or_si256(twice1, _mm256_and_si256(once1, mask1));
+        once0 = _mm256_or_si256(once0, mask0);
+        once1 = _mm256_or_si256(once1, mask1);
+    }
+
+    _mm256_storeu_si256((__m256i*)&once[0], once0);
+    _mm256_storeu_si256((__m256i*)&once[16], once1);
+    _mm256_storeu_si256((__m256i*)&twice[0], twice0);
+    _mm256_storeu_si256((__m256i*)&twice[16], twice1);
+
+    memcpy(counts.once, once, sizeof(counts.once));
+    memcpy(counts.twice, twice, sizeof(counts.twice));
+}
+
+static bool DetectAVX2()
+{
+#if defined(_MSC_VER)
+    int info[4];
+
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+
+    // AVX2 needs OSXSAVE and the OS saving the YMM registers as well as the AVX2 feature bit
+    __cpuid(info, 1);
+    if ((info[2] & (1 << 27)) == 0)
+        return false;
+
+    if ((_xgetbv(0) & 0x06) != 0x06)
+        return false;
+
+    __cpuidex(info, 7, 0);
+    return ((info[1] & (1 << 5)) != 0);
+#else
+    __builtin_cpu_init();
+    return (__builtin_cpu_supports("avx2") != 0);
+#endif
+}
+
+bool IsAVX2Supported()
+{
+    static const bool fSupported = DetectAVX2();
+    return fSupported;
+}
+
+#else
+
+void CountSetCandidatesAVX2(const BoardCore& core, SetCandidateCounts& counts)
+{
+    CountSetCandidatesScalar(core, counts);
+}
+
+bool IsAVX2Supported()
+{
+    return false;
+}
+
+#endif
+
+void CountSetCandidates(const BoardCore& core, SetCandidateCounts& counts)
+{
+    static void (* const pfnKernel)(const BoardCore&, SetCandidateCounts&) = IsAVX2Supported() ? CountSetCandidatesAVX2 : CountSetCandidatesScalar;
+
+    pfnKernel(core, counts);
+}
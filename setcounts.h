@@ -0,0 +1,42 @@
+/*
+    Copyright 2017 John Selbie
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+    
+        http://www.apache.org/licenses/LICENSE-2.0
+    
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef SUDOKU_SET_COUNTS_H
+#define SUDOKU_SET_COUNTS_H
+
+#include "boardcore.h"
+
+// SetCandidateCounts holds two masks for each of the 27 sets (numbered as in boardcore.h).
+// "once" has the values that appear in the candidate list of at least one cell of the set.
+// "twice" has the values that appear in the candidate lists of at least two cells of the set.
+// once & ~twice is the set of values that only one cell can hold, which is what hidden single detection needs.
+// Solved cells are included (their candidate list is just their value), so mask with BoardCore::placed as needed.
+struct SetCandidateCounts
+{
+    uint16_t once[27];
+    uint16_t twice[27];
+};
+
+// CountSetCandidates fills in "counts" for all 27 sets at once.  It uses the AVX2 kernel when the processor
+// supports it (checked once at runtime) and the scalar kernel otherwise.
+void CountSetCandidates(const BoardCore& core, SetCandidateCounts& counts);
+
+void CountSetCandidatesScalar(const BoardCore& core, SetCandidateCounts& counts);
+void CountSetCandidatesAVX2(const BoardCore& core, SetCandidateCounts& counts);
+
+// true if this build has the AVX2 kernel and the processor (and OS) can run it
+bool IsAVX2Supported();
+
+#endif
@@ -0,0 +1,100 @@
+/*
+    Copyright 2017 John Selbie
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "stdafx.h"
+#include "solvestats.h"
+
+static const char* g_stat_name[STAT_COUNT] =
+{
+    "SimpleEliminate",
+    "PropagateSingles",
+    "NakedSubsets",
+    "HiddenSubsets",
+    "LockedCandidates",
+    "Fish",
+    "Search"
+};
+
+TechniqueCounters::TechniqueCounters() :
+calls(0),
+hits(0),
+eliminated(0),
+placed(0),
+nanoseconds(0)
+{
+}
+
+void TechniqueCounters::Add(const TechniqueCounters& other)
+{
+    calls += other.calls;
+    hits += other.hits;
+    eliminated += other.eliminated;
+    placed += other.placed;
+    nanoseconds += other.nanoseconds;
+}
+
+void SolveStats::Reset()
+{
+    *this = SolveStats();
+}
+
+void SolveStats::Add(const SolveStats& other)
+{
+    for (int stat = 0; stat < STAT_COUNT; stat++)
+    {
+        techniques[stat].Add(other.techniques[stat]);
+    }
+    passes.Add(other.passes);
+}
+
+const char *SolveStats::GetName(int stat)
+{
+    if ((stat < 0) || (stat >= STAT_COUNT))
+        return "Unknown";
+
+    return g_stat_name[stat];
+}
+
+static void FormatCounters(const char *pszName, const TechniqueCounters& counters, std::string& out)
+{
+    char szLine[160];
+
+    snprintf(szLine, sizeof(szLine), "%-18s %12llu %12llu %12llu %12llu %12.3f\n",
+        pszName,
+        (unsigned long long)counters.calls,
+        (unsigned long long)counters.hits,
+        (unsigned long long)counters.eliminated,
+        (unsigned long long)counters.placed,
+        counters.nanoseconds / 1000000.0);
+
+    out += szLine;
+}
+
+std::string SolveStats::Format() const
+{
+    std::string out;
+    char szLine[160];
+
+    snprintf(szLine, sizeof(szLine), "%-18s %12s %12s %12s %12s %12s\n", "technique", "calls", "hits", "eliminated", "placed", "time (ms)");
+    out += szLine;
+
+    for (int stat = 0; stat < STAT_COUNT; stat++)
+    {
+        FormatCounters(GetName(stat), techniques[stat], out);
+    }
+    FormatCounters("passes", passes, out);
+
+    return out;
+}
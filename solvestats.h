@@ -0,0 +1,61 @@
+/*
+    Copyright 2017 John Selbie
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef SUDOKU_SOLVE_STATS_H
+#define SUDOKU_SOLVE_STATS_H
+
+// The solving algorithms that SolveStats keeps counters for, one per SudokuBoard method
+enum SOLVE_STAT
+{
+    STAT_SIMPLE_ELIMINATE,
+    STAT_PROPAGATE_SINGLES,
+    STAT_NAKED_SUBSETS,
+    STAT_HIDDEN_SUBSETS,
+    STAT_LOCKED_CANDIDATES,
+    STAT_FISH,
+    STAT_SEARCH,
+    STAT_COUNT
+};
+
+struct TechniqueCounters
+{
+    uint64_t calls;
+    uint64_t hits;         // calls that placed a value or removed a candidate
+    uint64_t eliminated;   // candidates removed directly (not counting the ones a placed value removes from its peers)
+    uint64_t placed;       // values placed
+    uint64_t nanoseconds;  // time spent in the calls
+
+    TechniqueCounters();
+    void Add(const TechniqueCounters& other);
+};
+
+// SolveStats holds the counters for each solving algorithm plus one set for the solve passes
+// (a pass is one ScanForSolution or PropagationPass).  The same struct is used for one board and for the
+// total of a batch run.
+struct SolveStats
+{
+    TechniqueCounters techniques[STAT_COUNT];
+    TechniqueCounters passes;
+
+    void Reset();
+    void Add(const SolveStats& other);
+
+    static const char *GetName(int stat);
+
+    // one line per algorithm, plus the passes, formatted as a table
+    std::string Format() const;
+};
+
+#endif
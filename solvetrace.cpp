@@ -0,0 +1,208 @@
+/*
+    Copyright 2017 John Selbie
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#include "stdafx.h"
+#include "bitops.h"
+#include "solvetrace.h"
+
+static const char* g_technique_name[TECHNIQUE_COUNT] =
+{
+    "NakedSingle",
+    "HiddenSingle",
+    "NakedSubset",
+    "HiddenSubset",
+    "BoxLineReduction",
+    "NumberClaiming",
+    "Fish",
+    "Search"
+};
+
+SolveTrace::SolveTrace() :
+m_count(0)
+{
+}
+
+void SolveTrace::Start(const BoardCore& core)
+{
+    m_start = core;
+    m_count = 0;
+}
+
+int SolveTrace::GetCount() const
+{
+    return m_count;
+}
+
+const TraceEvent& SolveTrace::GetEvent(int index) const
+{
+    assert(index >= 0);
+    assert(index < m_count);
+    return m_events[index];
+}
+
+const BoardCore& SolveTrace::GetStart() const
+{
+    return m_start;
+}
+
+const char *SolveTrace::GetTechniqueName(int technique)
+{
+    if ((technique < 0) || (technique >= TECHNIQUE_COUNT))
+        return "Unknown";
+
+    return g_technique_name[technique];
+}
+
+void SolveTrace::FormatEvent(const TraceEvent& event, std::string& out)
+{
+    char szLine[128];
+
+    if (event.action == TRACE_PLACED)
+    {
+        snprintf(szLine, sizeof(szLine), "%s - setting value of %d at (r=%d c=%d)\n", GetTechniqueName(event.technique), event.value, event.cellindex / 9, event.cellindex % 9);
+    }
+    else
+    {
+        snprintf(szLine, sizeof(szLine), "%s - removing %d from cell at (r=%d c=%d)\n", GetTechniqueName(event.technique), event.value, event.cellindex / 9, event.cellindex % 9);
+    }
+
+    out += szLine;
+}
+
+void SolveTrace::FormatGrid(const BoardCore& core, std::string& out)
+{
+    for (int row = 0; row < 9; row++)
+    {
+        for (int col = 0; col < 9; col++)
+        {
+            int cellindex = row * 9 + col;
+            int value = core.values[cellindex];
+
+            if (value != 0)
+            {
+                out += (char)(value + '0');
+                out += "      ";
+            }
+            else
+            {
+                out += '{';
+                for (int candidate : BitValues(core.masks[cellindex]))
+                {
+                    out += (char)(candidate + '0');
+                }
+                out += '}';
+                int remainingspaces = 5 - PopCount(core.masks[cellindex]);
+                if (remainingspaces > 0)
+                {
+                    out.append(remainingspaces, ' ');
+                }
+            }
+
+            if ((col % 3 == 2) && (col != 8))
+                out += "| ";
+        }
+
+        out += '\n';
+        if (row % 3 == 2)
+        {
+            out += "------------------------------------------------------------------\n";
+        }
+    }
+}
+
+std::string SolveTrace::FormatText() const
+{
+    std::string out;
+
+    for (int index = 0; index < m_count; index++)
+    {
+        FormatEvent(m_events[index], out);
+    }
+
+    return out;
+}
+
+std::string SolveTrace::FormatJson() const
+{
+    std::string out;
+    char szEvent[160];
+
+    out += "{\"start\":\"";
+    for (int cellindex = 0; cellindex < 81; cellindex++)
+    {
+        int value = m_start.values[cellindex];
+        out += value ? (char)(value + '0') : '.';
+    }
+    out += "\",\"events\":[";
+
+    for (int index = 0; index < m_count; index++)
+    {
+        const TraceEvent& event = m_events[index];
+
+        snprintf(szEvent, sizeof(szEvent), "%s{\"technique\":\"%s\",\"row\":%d,\"col\":%d,\"value\":%d,\"action\":\"%s\"}",
+            (index > 0) ? "," : "",
+            GetTechniqueName(event.technique),
+            event.cellindex / 9,
+            event.cellindex % 9,
+            event.value,
+            (event.action == TRACE_PLACED) ? "placed" : "eliminated");
+
+        out += szEvent;
+    }
+
+    out += "]}\n";
+    return out;
+}
+
+std::string SolveTrace::FormatReplay() const
+{
+    std::string out;
+    BoardCore core = m_start;
+
+    FormatGrid(core, out);
+
+    for (int index = 0; index < m_count; index++)
+    {
+        const TraceEvent& event = m_events[index];
+        uint16_t mask = (uint16_t)(0x01 << (event.value - 1));
+
+        if (event.action == TRACE_PLACED)
+        {
+            // placing a value takes it out of the candidate lists of the 20 peers, the same as SudokuBoard::SetCellValue
+            core.SetCell(event.cellindex, event.value, mask);
+            for (int peer = 0; peer < 20; peer++)
+            {
+                int peerindex = g_cellPeers[event.cellindex][peer];
+                core.SetMask(peerindex, core.masks[peerindex] & ~mask);
+            }
+        }
+        else
+        {
+            // every change goes through SetMask so the positions and counters stay in step with the masks
+            core.SetMask(event.cellindex, core.masks[event.cellindex] & ~mask);
+        }
+
+        FormatEvent(event, out);
+
+        bool fLast = (index + 1 == m_count);
+        if (fLast || (event.action == TRACE_PLACED) || (m_events[index + 1].action == TRACE_PLACED) || (m_events[index + 1].technique != event.technique))
+        {
+            out += '\n';
+            FormatGrid(core, out);
+        }
+    }
+
+    return out;
+}
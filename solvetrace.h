@@ -0,0 +1,100 @@
+/*
+    Copyright 2017 John Selbie
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+#ifndef SUDOKU_SOLVE_TRACE_H
+#define SUDOKU_SOLVE_TRACE_H
+
+#include "boardcore.h"
+
+enum TRACE_TECHNIQUE
+{
+    TECHNIQUE_NAKED_SINGLE,   // a cell with one candidate left
+    TECHNIQUE_HIDDEN_SINGLE,  // a value with one place left in a set
+    TECHNIQUE_NAKED_SUBSET,   // a pair, triple, or quad of cells with only that many candidates between them
+    TECHNIQUE_HIDDEN_SUBSET,  // a pair, triple, or quad of values with only that many places left in a set
+    TECHNIQUE_BOX_LINE,
+    TECHNIQUE_CLAIMING,
+    TECHNIQUE_FISH,           // X-Wing, Swordfish, or Jellyfish
+    TECHNIQUE_SEARCH,         // values filled in by the backtracking search (only the final answer is recorded)
+    TECHNIQUE_COUNT
+};
+
+enum TRACE_ACTION
+{
+    TRACE_PLACED,
+    TRACE_ELIMINATED
+};
+
+// One deduction.  Four bytes, so a whole solve fits in a few KB
+struct TraceEvent
+{
+    uint8_t technique;   // TRACE_TECHNIQUE
+    uint8_t cellindex;   // 0-80
+    uint8_t value;       // 1-9
+    uint8_t action;      // TRACE_ACTION
+};
+
+// SolveTrace records the deductions made while solving a board as binary events in a fixed buffer.  Nothing is
+// formatted while solving.  The text, JSON, and replay views are built from the events only when asked for.
+// Every event either places a value or removes a candidate, and each cell and candidate can only change once,
+// so a solve never has more than 81 + 729 events.
+class SolveTrace
+{
+public:
+    static const int MAX_EVENTS = 81 + 729;
+
+    SolveTrace();
+
+    // Start clears the events and records the board the events will be applied to
+    void Start(const BoardCore& core);
+
+    void Add(TRACE_TECHNIQUE technique, int cellindex, int value, TRACE_ACTION action)
+    {
+        if (m_count >= MAX_EVENTS)
+            return;
+
+        TraceEvent& event = m_events[m_count++];
+        event.technique = (uint8_t)technique;
+        event.cellindex = (uint8_t)cellindex;
+        event.value = (uint8_t)value;
+        event.action = (uint8_t)action;
+    }
+
+    int GetCount() const;
+    const TraceEvent& GetEvent(int index) const;
+    const BoardCore& GetStart() const;
+
+    static const char *GetTechniqueName(int technique);
+
+    // one line per event
+    std::string FormatText() const;
+
+    // {"start":"<81 chars>","events":[{"technique":...,"row":...,"col":...,"value":...,"action":...},...]}
+    std::string FormatJson() const;
+
+    // FormatReplay applies the events to the starting board and shows the candidate grid (the same layout
+    // as SudokuBoard::FullDump) after every placement and after every run of eliminations by one technique
+    std::string FormatReplay() const;
+
+private:
+    BoardCore m_start;
+    int m_count;
+    TraceEvent m_events[MAX_EVENTS];
+
+    static void FormatEvent(const TraceEvent& event, std::string& out);
+    static void FormatGrid(const BoardCore& core, std::string& out);
+};
+
+#endif
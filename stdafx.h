@@ -8,6 +8,9 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
 
 
 #include <assert.h>
@@ -15,7 +18,13 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <deque>
 #include <fstream>
 #include <sstream>
+#include <iterator>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #endif
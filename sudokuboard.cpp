@@ -16,9 +16,28 @@
 #include "stdafx.h"
 #include "sudokuboard.h"
 #include "cell.h"
-
-SudokuBoard::SudokuBoard()
+#include "bitops.h"
+
+SudokuBoard::SudokuBoard() :
+m_changecount(0),
+m_placedcount(0),
+m_peerclearcount(0),
+m_setcountsversion(0),
+m_fSetCountsValid(false),
+m_engine(ENGINE_SCAN),
+m_scancount(0),
+m_status(STATUS_STALLED),
+m_fSearched(false),
+m_fQueueing(false),
+m_queuehead(0),
+m_queuecount(0),
+m_fSearch(false),
+m_fTrail(false),
+m_loglevel(LOG_DUMPS),
+m_fTracing(false),
+m_fStats(false)
 {
+    m_trail.reserve(TRAIL_RESERVE);
     Init();
 }
 
@@ -40,6 +59,10 @@ bool SudokuBoard::Init()
         m_cols[i].Reset();
         m_squares[i].Reset();
     }
+
+    m_core.Reset();
+    m_fSetCountsValid = false;
+    m_trail.clear();
     // ------------------------------------------
 
     // start of initialization
@@ -78,10 +101,28 @@ bool SudokuBoard::Init()
         }
     }
 
-
     return true;
 }
 
+void SudokuBoard::Reset()
+{
+    for (int row = 0; row < 9; row++)
+    {
+        for (int col = 0; col < 9; col++)
+        {
+            Cell& cell = m_board[row][col];
+
+            cell._value = 0;
+            cell._bitmask = CELLINIT;
+            cell._isPermanent = false;
+        }
+    }
+
+    m_core.Reset();
+    m_fSetCountsValid = false;
+    m_trail.clear();
+}
+
 bool SudokuBoard::LoadFromFile(const std::string& filename)
 {
     std::ifstream infile(filename);
@@ -117,40 +158,149 @@ bool SudokuBoard::LoadFromFile(const std::string& filename)
 
     if (row != 9)
     {
-        Log("Error processing file!");
+        SOLVER_LOG(LOG_SUMMARY, "Error processing file!");
+        return false;
+    }
+
+    return true;
+}
+
+bool SudokuBoard::LoadFromBuffer(const char *buffer, size_t length)
+{
+    int row = 0;
+    int col = 0;
+    int value = 0;
+    size_t index;
+
+    for (index = 0; index < length; index++)
+    {
+        char c = buffer[index];
+
+        if ((c == ' ') || (c == '\t') || (c == '\r') || (c == '\n'))
+        {
+            continue;
+        }
+
+        value = 0;
+        if ((c >= '0') && (c <= '9'))
+        {
+            value = c - '0';
+        }
+
+        SetCellValue(row, col, value, true);
+
+        col++;
+        if (col == 9)
+        {
+            col = 0;
+            row++;
+        }
+        if (row == 9)
+        {
+            break;
+        }
+    }
+
+    // no log here, in memory loads are used by callers that don't want anything written to stdout
+    if (row != 9)
+    {
         return false;
     }
 
+    // anything but whitespace after the 81st cell means this isn't a one-puzzle buffer
+    for (index++; index < length; index++)
+    {
+        char c = buffer[index];
+
+        if ((c != ' ') && (c != '\t') && (c != '\r') && (c != '\n'))
+        {
+            return false;
+        }
+    }
+
     return true;
 }
 
+bool SudokuBoard::LoadFromString(const std::string& puzzle)
+{
+    return LoadFromBuffer(puzzle.data(), puzzle.size());
+}
+
 bool SudokuBoard::Solve()
 {
     bool fSolved = false;
 
+    if (m_fTracing)
+    {
+        m_trace.Start(m_core);
+    }
+
+    if (m_fStats)
+    {
+        m_stats.Reset();
+    }
+
+    m_scancount = 0;
+    m_fSearched = false;
+
+    // a board that was loaded full is solved only if no value is repeated
     if (IsSolved())
-        return true;
+    {
+        m_status = IsValid() ? STATUS_SOLVED : STATUS_INVALID;
+        return (m_status == STATUS_SOLVED);
+    }
 
     int scancount = 0;
-    std::string oldstate, state;
-    state = GetBoardState();
-
-    Log("\n");
-    Dump();
-    Log("\n");
+    int changecount = 0;
 
-    while(true)
+    // a board that already has a cell or a value with no place left has no solution.  It gets no pass, so every
+    // engine leaves the grid as it was loaded
+    if (HasContradiction())
     {
-        oldstate = state;
-        ScanForSolution();
-        scancount++;
-        state = GetBoardState();
+        changecount = -1;
+    }
 
+    if (SOLVER_LOG_ENABLED(LOG_SUMMARY))
+    {
         Log("\n");
         Dump();
         Log("\n");
+    }
+
+    if ((m_engine == ENGINE_PROPAGATE) || (m_engine == ENGINE_ADAPTIVE))
+    {
+        StartQueueing();
+    }
 
-        if (state == oldstate)
+    while (changecount >= 0)
+    {
+        if (m_engine == ENGINE_PROPAGATE)
+        {
+            changecount = PropagationPass();
+        }
+        else if (m_engine == ENGINE_ADAPTIVE)
+        {
+            changecount = AdaptivePass();
+        }
+        else
+        {
+            changecount = ScanForSolution();
+        }
+        scancount++;
+
+        if (SOLVER_LOG_ENABLED(LOG_DUMPS))
+        {
+            Log("\n");
+            Dump();
+            Log("\n");
+        }
+
+        if (HasContradiction())
+        {
+            changecount = -1;
+        }
+
+        if (changecount <= 0)
             break;
 
 
@@ -161,97 +311,184 @@ bool SudokuBoard::Solve()
         }
     }
 
-    Log("Number of scans - %d", scancount);
+    StopQueueing();
+
+    // below the dumps level the board is only shown once the logic is done
+    if (SOLVER_LOG_ENABLED(LOG_SUMMARY) && (SOLVER_LOG_ENABLED(LOG_DUMPS) == false))
+    {
+        Log("\n");
+        Dump();
+        Log("\n");
+    }
+
+    SOLVER_LOG(LOG_SUMMARY, "Number of scans - %d", scancount);
+
+    if ((fSolved == false) && m_fSearch && (changecount >= 0))
+    {
+        SOLVER_LOG(LOG_SUMMARY, "Logic has stalled, searching");
+        fSolved = Search();
+        m_fSearched = true;
+
+        if (fSolved && SOLVER_LOG_ENABLED(LOG_SUMMARY))
+        {
+            Log("\n");
+            Dump();
+            Log("\n");
+        }
+    }
+
     if (fSolved)
     {
-        Log("Board has been solved");
+        SOLVER_LOG(LOG_SUMMARY, "Board has been solved");
     }
     else
     {
-        Log("Board has not been solved");
-        Log("");
+        SOLVER_LOG(LOG_SUMMARY, "Board has not been solved");
+        SOLVER_LOG(LOG_SUMMARY, "");
     }
 
     bool fValid = IsValid();
-    Log("%sBoard is%s valid", fValid?"":"WARNING - ", fValid?"":" NOT");
+    SOLVER_LOG(LOG_SUMMARY, "%sBoard is%s valid", fValid?"":"WARNING - ", fValid?"":" NOT");
+
+    // a search that runs out of guesses has proven there is no solution
+    m_scancount = scancount;
+    if (fSolved && fValid)
+    {
+        m_status = STATUS_SOLVED;
+    }
+    else if ((fValid == false) || (changecount < 0) || m_fSearched)
+    {
+        m_status = STATUS_INVALID;
+    }
+    else
+    {
+        m_status = STATUS_STALLED;
+    }
 
     return fSolved;
 }
 
-
-
-bool SudokuBoard::IsSolved()
+bool SudokuBoard::Solve(SolveResult& result)
 {
-    // it's solved if all 81 squares have a non-zero value and the board is valid
+    LOG_LEVEL loglevel = m_loglevel;
 
-    for (int r = 0; r < 9; r++)
-    {
-        for (int c = 0; c < 9; c++)
-        {
-            if (m_board[r][c]._value == 0)
-                return false;
-        }
-    }
+    m_loglevel = LOG_OFF;
+    bool fSolved = Solve();
+    m_loglevel = loglevel;
 
-    return true;
-}
+    GetBoardLine(result.grid);
+    result.status = m_status;
+    result.scancount = m_scancount;
+    result.fValid = IsValid();
+    result.fSearched = m_fSearched;
 
+    return fSolved;
+}
 
 
 
+bool SudokuBoard::IsSolved()
+{
+    // every cell has a value.  m_core counts the unsolved cells as values are placed
+    return (m_core.unsolved == 0);
+}
 
 bool SudokuBoard::IsValid()
 {
-    // check for validity
-    int squarecount[9][10] = {0};
-    int rowcount[9][10] = {0};
-    int colcount[9][10] = {0};
+    // no value is placed twice in a row, column, or square
+    return (m_core.conflicts == 0);
+}
 
-    for (int index = 0; index < 9; index++)
-    {
-        CellSet *square = &m_squares[index];
-        CellSet *row = &m_rows[index];
-        CellSet *col = &m_cols[index];
+bool SudokuBoard::HasContradiction() const
+{
+    return (m_core.contradictions != 0);
+}
 
-        for (int cellindex = 0; cellindex < 9; cellindex++)
-        {
-            int value;
 
-            value = square->_set[cellindex]->_value;
-            squarecount[index][value]++;
 
-            value = row->_set[cellindex]->_value;
-            rowcount[index][value]++;
 
-            value = col->_set[cellindex]->_value;
-            colcount[index][value]++;
-        }
-    }
 
-    for (int index = 0; index < 9; index++)
-    {
-        for (int valueindex = 1; valueindex <= 9; valueindex++)
-        {
-            if (squarecount[index][valueindex] > 1)
-                return false;
+void SudokuBoard::SetLogLevel(LOG_LEVEL level)
+{
+    m_loglevel = level;
+}
 
-            if (rowcount[index][valueindex] > 1)
-                return false;
+void SudokuBoard::SetTracing(bool fEnable)
+{
+    m_fTracing = fEnable;
+}
 
-            if (colcount[index][valueindex] > 1)
-                return false;
-        }
+const SolveTrace& SudokuBoard::GetTrace() const
+{
+    return m_trace;
+}
+
+void SudokuBoard::Trace(TRACE_TECHNIQUE technique, Cell *cell, int value, TRACE_ACTION action)
+{
+    if (m_fTracing)
+    {
+        m_trace.Add(technique, cell->_cellIndex, value, action);
     }
+}
 
-    return true;
+void SudokuBoard::SetStats(bool fEnable)
+{
+    m_fStats = fEnable;
+}
+
+const SolveStats& SudokuBoard::GetStats() const
+{
+    return m_stats;
 }
 
+SudokuBoard::StatsScope::StatsScope(SudokuBoard *board, TechniqueCounters& counters) :
+m_board(board),
+m_counters(nullptr),
+m_changecount(0),
+m_placedcount(0),
+m_peerclearcount(0)
+{
+    if (board->m_fStats)
+    {
+        m_counters = &counters;
+        m_changecount = board->m_changecount;
+        m_placedcount = board->m_placedcount;
+        m_peerclearcount = board->m_peerclearcount;
+        m_start = std::chrono::steady_clock::now();
+    }
+}
 
+SudokuBoard::StatsScope::~StatsScope()
+{
+    if (m_counters == nullptr)
+        return;
+
+    uint32_t changes = m_board->m_changecount - m_changecount;
+    uint32_t placed = m_board->m_placedcount - m_placedcount;
+    uint32_t peercleared = m_board->m_peerclearcount - m_peerclearcount;
+
+    m_counters->calls++;
+    m_counters->hits += (changes != 0) ? 1 : 0;
+    m_counters->placed += placed;
+    m_counters->eliminated += changes - placed - peercleared;
+    m_counters->nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start).count();
+}
 
+void SudokuBoard::SetEngine(SOLVE_ENGINE engine)
+{
+    m_engine = engine;
+}
 
+void SudokuBoard::SetSearchFallback(bool fEnable)
+{
+    m_fSearch = fEnable;
+}
 
 void SudokuBoard::LogWithoutLineBreak(const char *pwszFormat, ...)
 {
+    if (m_loglevel == LOG_OFF)
+        return;
+
     va_list args;
     va_start(args, pwszFormat);
     char szMsg[1024];
@@ -265,13 +502,16 @@ void SudokuBoard::LogWithoutLineBreak(const char *pwszFormat, ...)
 
 void SudokuBoard::Log(const char *pwszFormat, ...)
 {
+    if (m_loglevel == LOG_OFF)
+        return;
+
     va_list args;
     va_start(args, pwszFormat);
     char szMsg[1024];
 
     vsnprintf(szMsg, 1024, pwszFormat, args);
 
-    std::cout << szMsg << std::endl;
+    std::cout << szMsg << '\n';
 
     va_end(args);
 }
@@ -295,6 +535,71 @@ std::string SudokuBoard::GetBoardState()
     return ss.str();
 }
 
+void SudokuBoard::GetBoardLine(char *pszLine)
+{
+    for (int cellindex = 0; cellindex < 81; cellindex++)
+    {
+        int value = m_core.values[cellindex];
+        *pszLine++ = value ? (char)(value + '0') : '.';
+    }
+    *pszLine = '\0';
+}
+
+const BoardCore& SudokuBoard::GetCore() const
+{
+    return m_core;
+}
+
+int SudokuBoard::GetSetIndex(Cell *cell, CellSet *set)
+{
+    switch (cell->GetRelationship(set))
+    {
+        case CELL_ROW:
+            return SET_ROW_BASE + cell->_rowIndex;
+        case CELL_COLUMN:
+            return SET_COLUMN_BASE + cell->_colIndex;
+        case CELL_SQUARE:
+            return SET_SQUARE_BASE + cell->_squareIndex;
+        default:
+            assert(false);
+            return 0;
+    }
+}
+
+const SetCandidateCounts& SudokuBoard::GetSetCandidateCounts()
+{
+    // only recount when something has changed since the last count
+    if ((m_fSetCountsValid == false) || (m_setcountsversion != m_changecount))
+    {
+        CountSetCandidates(m_core, m_setcounts);
+        m_setcountsversion = m_changecount;
+        m_fSetCountsValid = true;
+    }
+
+    return m_setcounts;
+}
+
+Cell *SudokuBoard::GetCell(int cellindex)
+{
+    assert(cellindex >= 0);
+    assert(cellindex < 81);
+
+    return &m_board[cellindex / 9][cellindex % 9];
+}
+
+bool SudokuBoard::IsCoreInSync()
+{
+    BoardCore core;
+
+    for (int cellindex = 0; cellindex < 81; cellindex++)
+    {
+        Cell *cell = GetCell(cellindex);
+        core.SetCell(cellindex, cell->_value, cell->_bitmask);
+    }
+
+    return core.IsEqual(m_core);
+}
+
 void SudokuBoard::SetCellValue(int row, int col, int value, bool fPerm)
 {
     assert(row >=0);
@@ -310,9 +615,30 @@ void SudokuBoard::SetCellValue(int row, int col, int value, bool fPerm)
 
 void SudokuBoard::SetCellValue(Cell *cell, int value, bool fPerm)
 {
+    if ((value != 0) && (cell->_value != value))
+    {
+        m_changecount++;
+        m_placedcount++;
+    }
+
+    uint32_t startcount = m_changecount;
+    int oldvalue = cell->_value;
+    uint16_t oldmask = cell->_bitmask;
+
     cell->SetValue(value);
     cell->_isPermanent = fPerm && (value != 0);
 
+    if (m_fTrail && ((cell->_value != oldvalue) || (cell->_bitmask != oldmask)))
+    {
+        AppendTrail(cell->_cellIndex, oldvalue, oldmask);
+    }
+    m_core.SetCell(cell->_cellIndex, cell->_value, cell->_bitmask);
+
+    if (m_fQueueing && (value != 0))
+    {
+        QueueCell(cell);
+    }
+
     // clear out the value bit from all the cells in the same row,col, and square
     CellSet* rowset = cell->_row;
     CellSet* square = cell->_square;
@@ -322,658 +648,980 @@ void SudokuBoard::SetCellValue(Cell *cell, int value, bool fPerm)
     {
         if (cell != rowset->_set[index])
         {
-            rowset->_set[index]->ClearValueFromMask(value);
+            ClearCandidate(rowset->_set[index], value);
         }
 
         if (cell != colset->_set[index])
         {
-            colset->_set[index]->ClearValueFromMask(value);
+            ClearCandidate(colset->_set[index], value);
         }
 
         if (cell != square->_set[index])
         {
-            square->_set[index]->ClearValueFromMask(value);
+            ClearCandidate(square->_set[index], value);
         }
     }
 
+    m_peerclearcount += m_changecount - startcount;
+
     return;
 
 }
 
-
-void SudokuBoard::ScanForSolution()
+bool SudokuBoard::ClearCandidate(Cell *cell, int value)
 {
-    // this function is the main loop that looks for a solution
-    int value = 0;
-
-    for (int r = 0; r < 9; r++)
+    if (cell->ClearValueFromMask(value) == false)
     {
-        for (int c = 0; c < 9; c++)
-        {
-            Cell *cell = &m_board[r][c];
-
-            if (cell->_value != 0)  // cell is already solved
-            {
-                continue;
-            }
-
-            value = SimpleEliminate(cell, cell->_square);
-            if (value == 0)
-            {
-                value = SimpleEliminate(cell, cell->_row);
-            }
-            if (value == 0)
-            {
-                value = SimpleEliminate(cell, cell->_column);
-            }
-
-            if (value != 0)
-            {
-                continue;
-            }
-
-            PairSearch(cell, cell->_square);
-            PairSearch(cell, cell->_row);
-            PairSearch(cell, cell->_column);
-
-            TripleSearch(cell, cell->_square);
-            TripleSearch(cell, cell->_row);
-            TripleSearch(cell, cell->_column);
-
-        }
+        return false;
     }
 
-
-    for (int index = 0; index < 9; index++)
+    if (m_fTrail)
     {
-        BoxLineReduction(&m_rows[index]);
-        BoxLineReduction(&m_cols[index]);
+        AppendTrail(cell->_cellIndex, cell->_value, (uint16_t)(cell->_bitmask | (0x01 << (value - 1))));
     }
 
+    m_core.SetMask(cell->_cellIndex, cell->_bitmask);
+    m_changecount++;
 
-    for (int index = 0; index < 9; index++)
+    if (m_fQueueing)
     {
-        DoNumberClaiming(&m_squares[index]);
+        QueueCell(cell);
     }
 
-    //FullDump();
-    DoXWingSets(m_cols);
-    DoXWingSets(m_rows);
+    return true;
 }
 
-// SimpleEliminate looks at the non-eliminated values at "cell" and compares it to all the
-// other non-eliminated values from the {square,row,column} set.  If a non-eliminated value appears only once,
-// then it
-int SudokuBoard::SimpleEliminate(Cell *cell, CellSet *set)
+void SudokuBoard::StartQueueing()
 {
-    uint16_t wOtherMask = 0;
-    int value = 0;
+    m_fQueueing = true;
+    m_queuehead = 0;
+    m_queuecount = 0;
+    memset(m_queued, 0, sizeof(m_queued));
 
-    if (cell->_value != 0)
+    for (int item = 0; item < QUEUE_SIZE; item++)
     {
-        return 0;
+        QueueItem(item);
     }
+}
+
+void SudokuBoard::StopQueueing()
+{
+    m_fQueueing = false;
+    ClearQueue();
+}
+
+void SudokuBoard::ClearQueue()
+{
+    m_queuehead = 0;
+    m_queuecount = 0;
+    memset(m_queued, 0, sizeof(m_queued));
+}
+
+void SudokuBoard::QueueCell(Cell *cell)
+{
+    QueueItem(cell->_cellIndex);
+    QueueItem(81 + SET_ROW_BASE + cell->_rowIndex);
+    QueueItem(81 + SET_COLUMN_BASE + cell->_colIndex);
+    QueueItem(81 + SET_SQUARE_BASE + cell->_squareIndex);
+}
+
+void SudokuBoard::QueueItem(int item)
+{
+    if (m_queued[item])
+        return;
+
+    assert(m_queuecount < QUEUE_SIZE);
+
+    m_queued[item] = true;
+    m_queue[(m_queuehead + m_queuecount) % QUEUE_SIZE] = (uint8_t)item;
+    m_queuecount++;
+}
+
+bool SudokuBoard::PropagateSingles()
+{
+    StatsScope scope(this, m_stats.techniques[STAT_PROPAGATE_SINGLES]);
 
-    if (Cell::BitCount(cell->_bitmask) == 1)
+    while (m_queuecount > 0)
     {
-        // all other values have been eliminated for this cell, it must be "the one"
-        value = Cell::GetCellValueFromBitmask(cell->_bitmask);
-        SetCellValue(cell->_rowIndex, cell->_colIndex, value);
-        LogWithoutLineBreak("SimpleEliminate - Single Bit match.  Setting %d for (r=%d c=%d)\n", value, cell->_rowIndex, cell->_colIndex);
-        return value;
+        // m_core flags an empty cell or a value with no place left as soon as the candidate goes, no need to wait for
+        // the cell or set to come up in the queue
+        if (HasContradiction())
+        {
+            SOLVER_LOG(LOG_STEPS, "Propagate - a cell or a value has no candidates left");
+            ClearQueue();
+            return false;
+        }
+
+        int item = m_queue[m_queuehead];
+        m_queuehead = (m_queuehead + 1) % QUEUE_SIZE;
+        m_queuecount--;
+        m_queued[item] = false;
+
+        if (item >= 81)
+        {
+            if (PropagateSet(item - 81) == false)
+            {
+                ClearQueue();
+                return false;
+            }
+            continue;
+        }
+
+        Cell *cell = GetCell(item);
+
+        if (cell->_value != 0)
+            continue;
+
+        if (cell->_bitmask == 0)
+        {
+            SOLVER_LOG(LOG_STEPS, "Propagate - no candidates left for cell at (r=%d c=%d)", cell->_rowIndex, cell->_colIndex);
+            ClearQueue();
+            return false;
+        }
+
+        if (PopCount(cell->_bitmask) == 1)
+        {
+            int value = LowestBitIndex(cell->_bitmask) + 1;
+            SetCellValue(cell, value);
+            Trace(TECHNIQUE_NAKED_SINGLE, cell, value, TRACE_PLACED);
+            SOLVER_LOG(LOG_STEPS, "Propagate - Single Bit match.  Setting %d for (r=%d c=%d)", value, cell->_rowIndex, cell->_colIndex);
+        }
     }
 
+    return true;
+}
+
+bool SudokuBoard::PropagateSet(int setindex)
+{
+    const uint8_t *cells = g_setCells[setindex];
+    uint16_t wPlaced = m_core.placed[setindex];
+    uint16_t wOnce = 0;    // candidates seen in at least one unsolved cell
+    uint16_t wTwice = 0;   // candidates seen in at least two unsolved cells
 
     for (int index = 0; index < 9; index++)
     {
-        Cell *othercell = set->_set[index];
+        int cellindex = cells[index];
 
-        if (othercell != cell)
+        if (m_core.values[cellindex] == 0)
         {
-            wOtherMask |= othercell->_bitmask;
+            uint16_t wMask = m_core.masks[cellindex];
+            wTwice |= (wOnce & wMask);
+            wOnce |= wMask;
         }
     }
 
-    // subtract wOtherMask from cell->m_bitmask
-    // if the result is something that has only 1 bit set, then it follows that there is exactly one value for that cell
+    if ((wPlaced | wOnce) != CELLINIT)
+    {
+        SOLVER_LOG(LOG_STEPS, "Propagate - a value has no place left in the %s", g_relationship_name[CELL_ROW + (setindex / 9)]);
+        return false;
+    }
 
-    uint16_t wResult = (cell->_bitmask & ~wOtherMask);
+    uint16_t wSingles = wOnce & ~wTwice & ~wPlaced;
 
-    if (Cell::BitCount(wResult) == 1)
+    for (int value : BitValues(wSingles))
     {
-        value = Cell::GetCellValueFromBitmask(wResult);
+        uint16_t wValue = 0x01 << (value - 1);
 
-        SetCellValue(cell, value);
+        for (int index = 0; index < 9; index++)
+        {
+            int cellindex = cells[index];
 
-        CELL_RELATIONSHIP relate = cell->GetRelationship(set);
+            if ((m_core.values[cellindex] == 0) && (m_core.masks[cellindex] & wValue))
+            {
+                Cell *cell = GetCell(cellindex);
 
-        const char *psz = g_relationship_name[relate];
+                if (PopCount(m_core.masks[cellindex] & wOnce & ~wTwice & ~wPlaced) > 1)
+                {
+                    SOLVER_LOG(LOG_STEPS, "Propagate - more than one value can only go in cell at (r=%d c=%d)", cell->_rowIndex, cell->_colIndex);
+                    return false;
+                }
 
-        Log("SimpleEliminate - setting value of %d at (r=%d c=%d) [%s elimination]", value, cell->_rowIndex, cell->_colIndex, psz);
+                SetCellValue(cell, value);
+                Trace(TECHNIQUE_HIDDEN_SINGLE, cell, value, TRACE_PLACED);
+                SOLVER_LOG(LOG_STEPS, "Propagate - setting value of %d at (r=%d c=%d) [%s elimination]", value, cell->_rowIndex, cell->_colIndex, g_relationship_name[CELL_ROW + (setindex / 9)]);
+                break;
+            }
+        }
     }
 
-    return value;
+    return true;
 }
 
-int SudokuBoard::BoxLineReduction(CellSet *set)
+int SudokuBoard::PropagationPass()
 {
+    StatsScope scope(this, m_stats.passes);
 
-    bool placed[10] = {0};
-    Cell *cell = NULL;
-    Cell *comparecell = NULL;
-    bool fCanDoBoxLineReduction;
-    int reducecount = 0;
-    
-    for (int cellindex = 0; cellindex < 9; cellindex++)
+    uint32_t startcount = m_changecount;
+
+    if (PropagateSingles() == false)
     {
-        int value = set->_set[cellindex]->_value;
-        placed[value] = true;  // value[0] is irrelevant
+        return -1;
     }
 
-    for (int valueindex = 1; valueindex <= 9; valueindex++)
+    if (IsSolved() == false)
     {
-        fCanDoBoxLineReduction = true;
-        comparecell = NULL;
+        ScanForEliminations();
+    }
 
-        if (placed[valueindex] == true)
-        {
-            continue;
-        }
+    return (int)(m_changecount - startcount);
+}
 
-        // look at all the cells in this set that have index in the candidate list.   If all the cells of this set appear
-        // in the same box, we can do boxline reduction
+void SudokuBoard::ScanForEliminations()
+{
+    SweepNakedSubsets();
+    SweepHiddenSubsets();
 
-        for (uint16_t cellindex = 0; cellindex < 9; cellindex++)
-        {
-            cell = set->_set[cellindex];
+    SweepLockedCandidates();
 
-            if (cell->_value != 0)
-            {
-                continue;
-            }
+    FishSearch(SET_COLUMN_BASE);
+    FishSearch(SET_ROW_BASE);
+}
 
-            if (cell->IsOkToSetValue(valueindex))
-            {
-                // we found a cell that contains a missing value for this set it it's candidate list
-                if (comparecell == NULL)
-                {
-                    comparecell = cell;
-                }
-                else
-                {
-                    if (comparecell->_square != cell->_square)
-                    {
-                        // "index" appears in m_bitmask in cells across different boxes - time to skip
-                        fCanDoBoxLineReduction = false;
-                        break;
-                    }
-                }
-            }
-        }
+// cheapest first
+const SudokuBoard::TechniqueSweep SudokuBoard::s_schedule[] =
+{
+    &SudokuBoard::SweepLockedCandidates,
+    &SudokuBoard::SweepNakedSubsets,
+    &SudokuBoard::SweepHiddenSubsets,
+    &SudokuBoard::SweepFish
+};
 
-        cell = NULL;
+const int SudokuBoard::SCHEDULE_SIZE = sizeof(SudokuBoard::s_schedule) / sizeof(SudokuBoard::s_schedule[0]);
 
-        if (comparecell && fCanDoBoxLineReduction)
-        {
-            CellSet *square = comparecell->_square;
+int SudokuBoard::AdaptivePass()
+{
+    StatsScope scope(this, m_stats.passes);
 
-            // iterate over all the cells in the square that don't belong to "set" (row/column)
-            for (uint16_t cellindex = 0; cellindex < 9; cellindex++)
-            {
-                cell = square->_set[cellindex];
-                if  ((cell->_row == set) || (cell->_column == set))
-                {
-                    continue;
-                }
+    uint32_t startcount = m_changecount;
 
-                assert(cell != comparecell);
+    if (PropagateSingles() == false)
+    {
+        return -1;
+    }
 
-                assert(cell->_value != valueindex);
+    if (IsSolved())
+    {
+        return (int)(m_changecount - startcount);
+    }
 
-                // another cell in the same square that doesn't belong to "set", remove valueindex from the bitmask
-                if (cell->ClearValueFromMask(valueindex))
-                {
-                    Log("BoxLineReduced %d from cell(r=%d c=%d)", valueindex, cell->_rowIndex, cell->_colIndex);
-                    reducecount++;
-                }
-            }
+    for (int index = 0; index < SCHEDULE_SIZE; index++)
+    {
+        if ((this->*s_schedule[index])() > 0)
+        {
+            break;
         }
     }
 
-    return reducecount;
+    return (int)(m_changecount - startcount);
 }
 
-int SudokuBoard::ClaimNumbers(uint16_t mask, CellSet *square, CellSet *set)
+int SudokuBoard::SweepLockedCandidates()
 {
-    // Remove all the values of "mask" from "set" that are not in "square"
+    uint32_t startcount = m_changecount;
 
-    int value;
-    int count = 0;
-    
-    value = Cell::GetCellValueFromBitmaskAndClear(mask);
-    while (value != 0)
+    for (int intersection = 0; intersection < INTERSECTION_COUNT; intersection++)
     {
-        for (int index = 0; index < 9; index++)
-        {
-            Cell *cell = set->_set[index];
-            if ((cell->_square != square) && (cell->_value == 0))
-            {
-                if (cell->IsOkToSetValue(value))
-                {
-                    Log("Number Claiming - removing %d from candidate list of cell at (r=%d c=%d)", value, cell->_rowIndex, cell->_colIndex);
-                }
+        LockedCandidates(intersection);
+    }
 
-                cell->ClearValueFromMask(value);
-                count++;
-            }
-        }
+    return (int)(m_changecount - startcount);
+}
+
+int SudokuBoard::SweepNakedSubsets()
+{
+    uint32_t startcount = m_changecount;
+
+    for (int index = 0; index < 9; index++)
+    {
+        NakedSubsets(SET_SQUARE_BASE + index);
+        NakedSubsets(SET_ROW_BASE + index);
+        NakedSubsets(SET_COLUMN_BASE + index);
+    }
+
+    return (int)(m_changecount - startcount);
+}
+
+int SudokuBoard::SweepHiddenSubsets()
+{
+    uint32_t startcount = m_changecount;
 
-        value = Cell::GetCellValueFromBitmaskAndClear(mask);
+    for (int setindex = 0; setindex < 27; setindex++)
+    {
+        HiddenSubsets(setindex);
     }
 
-    return count;
+    return (int)(m_changecount - startcount);
+}
+
+int SudokuBoard::SweepFish()
+{
+    uint32_t startcount = m_changecount;
+
+    FishSearch(SET_COLUMN_BASE);
+    FishSearch(SET_ROW_BASE);
+
+    return (int)(m_changecount - startcount);
 }
 
-int SudokuBoard::DoNumberClaiming(CellSet *square)
+bool SudokuBoard::Search()
 {
-    int count  = 0;
-    uint16_t maskPerRow[3] ={0};
-    uint16_t maskPerCol[3] = {0};
-    uint16_t wMaskRow;
-    uint16_t wMaskCol;
+    StatsScope scope(this, m_stats.techniques[STAT_SEARCH]);
+
+    int guesscount = 0;
+    bool fTracing = m_fTracing;
+    bool fStats = m_fStats;
+    BoardSnapshot start;
+
+    SaveSnapshot(start);
 
-    for (int r = 0; r < 3; r++)
+    // the guesses that lead to dead ends aren't deductions, only the answer the search finds gets traced.
+    // The propagation inside the search is counted as part of the search
+    m_fTracing = false;
+    m_fStats = false;
+    bool fSolved = (SearchSolutions(1, guesscount) == 1);
+    m_fTracing = fTracing;
+    m_fStats = fStats;
+
+    if (fSolved)
     {
-        wMaskRow = 0;
-        for (int c = 0; c < 3; c++)
+        for (int cellindex = 0; cellindex < 81; cellindex++)
         {
-            Cell *cell = square->_set[r*3+c];
-            if (cell->_value == 0)
+            if ((start.core.values[cellindex] == 0) && (m_core.values[cellindex] != 0))
             {
-                wMaskRow |= cell->_bitmask;
+                Trace(TECHNIQUE_SEARCH, GetCell(cellindex), m_core.values[cellindex], TRACE_PLACED);
             }
         }
-        maskPerRow[r] = wMaskRow;
     }
 
-    for (int c = 0; c < 3; c++)
+    SOLVER_LOG(LOG_SUMMARY, "Search - %d guesses, %s", guesscount, fSolved ? "found a solution" : "no solution exists");
+
+    return fSolved;
+}
+
+int SudokuBoard::CountSolutions(int limit)
+{
+    BoardSnapshot start;
+    size_t startmark = m_trail.size();
+    int guesscount = 0;
+    LOG_LEVEL loglevel = m_loglevel;
+    bool fTracing = m_fTracing;
+    bool fStats = m_fStats;
+
+    // the guesses and dead ends of a count aren't worth logging, tracing, or counting
+    m_loglevel = LOG_OFF;
+    m_fTracing = false;
+    m_fStats = false;
+
+    SaveSnapshot(start);
+    int solutioncount = SearchSolutions(limit, guesscount);
+    RestoreSnapshot(start);
+
+    // a search that hit the limit leaves its entries on a trail the caller was recording.  The snapshot already
+    // undid them, so drop them before a rollback by the caller could apply them again
+    m_trail.resize(startmark);
+
+    m_loglevel = loglevel;
+    m_fTracing = fTracing;
+    m_fStats = fStats;
+
+    return solutioncount;
+}
+
+int SudokuBoard::SearchSolutions(int limit, int& guesscount)
+{
+    int depth = 0;
+    int solutioncount = 0;
+    bool fTrail = m_fTrail;
+    size_t startmark = m_trail.size();
+
+    if (limit <= 0)
+    {
+        limit = INT_MAX;
+    }
+
+    // initial values that break the rules can never lead to a solution
+    if (IsValid() == false)
+    {
+        return 0;
+    }
+
+    // backtracking undoes only the changes made since the guess, read back from the trail
+    m_fTrail = true;
+
+    // the first frame holds the state logic left us with.  Propagate once more so that the scan engine
+    // gets the same contradiction checks as every search node
+    StartQueueing();
+
+    if (PropagateSingles())
     {
-        wMaskCol = 0;
-        for (int r = 0; r < 3; r++)
+        if (IsSolved())
+        {
+            solutioncount = 1;
+        }
+        else if (PushSearchFrame(0))
         {
-            Cell *cell = square->_set[r*3+c];
-            if (cell->_value == 0)
+            while (depth >= 0)
             {
-                wMaskCol |= cell->_bitmask;
+                SearchFrame& frame = m_searchstack[depth];
+
+                if (frame.candidates == 0)
+                {
+                    // every value for this cell has been tried, back up to the previous guess
+                    depth--;
+                    continue;
+                }
+
+                int value = LowestBitIndex(frame.candidates) + 1;
+                frame.candidates = (uint16_t)ClearLowestBit(frame.candidates);
+
+                RollbackTrail(frame.trailmark);
+                SetCellValue(GetCell(frame.cellindex), value);
+                guesscount++;
+
+                if (PropagateSingles() == false)
+                {
+                    continue;
+                }
+
+                if (IsSolved())
+                {
+                    solutioncount++;
+                    if (solutioncount >= limit)
+                        break;
+
+                    // keep going with the next value for this cell
+                    continue;
+                }
+
+                if (PushSearchFrame(depth + 1))
+                {
+                    depth++;
+                }
             }
         }
-        maskPerCol[c] = wMaskCol;
     }
 
-    // for each row/col, look to see if there are any bits in the mask that are not in the other two row/cols
+    if (solutioncount < limit)
+    {
+        // the search ran to the end, put the board back the way logic left it
+        RollbackTrail(startmark);
+    }
+    else if (fTrail == false)
+    {
+        // keep the solution, but the caller wasn't recording and has no use for the entries
+        m_trail.resize(startmark);
+    }
+
+    m_fTrail = fTrail;
+    StopQueueing();
+
+    return solutioncount;
+}
+
+bool SudokuBoard::PushSearchFrame(int depth)
+{
+    int bestcell = -1;
+    int bestcount = 10;
+
+    assert(depth < 81);
 
-    for (int r = 0; r < 3; r++)
+    // branch on the unsolved cell with the fewest candidates
+    for (int cellindex = 0; cellindex < 81; cellindex++)
     {
-        uint16_t wMaskedOut;
-        int rx[3][3] = {{0,1,2}, {1,0,2}, {2,0,1}};
-        wMaskedOut = (maskPerRow[rx[r][0]] & ~(maskPerRow[rx[r][1]] | maskPerRow[rx[r][2]]));
+        if (m_core.values[cellindex] != 0)
+            continue;
 
-        if (wMaskedOut != 0)
+        int count = PopCount(m_core.masks[cellindex]);
+        if (count < bestcount)
         {
-            Cell *refcell = square->_set[r*3];
-            CellSet *row = refcell->_row;
-            count += ClaimNumbers(wMaskedOut, square, row);
+            bestcount = count;
+            bestcell = cellindex;
+
+            if (count <= 2)
+                break;
         }
     }
 
-    for (int c = 0; c < 3; c++)
+    if ((bestcell == -1) || (bestcount == 0))
     {
-        uint16_t wMaskedOut;
-        int cx[3][3] = {{0,1,2}, {1,0,2}, {2,0,1}};
-        wMaskedOut = (maskPerCol[cx[c][0]] & ~(maskPerCol[cx[c][1]] | maskPerCol[cx[c][2]]));
-
-        if (wMaskedOut != 0)
-        {
-            Cell *refcell = square->_set[c];
-            CellSet *col = refcell->_column;
-            count += ClaimNumbers(wMaskedOut, square, col);
-        }
+        return false;
     }
 
-    return count;
+    SearchFrame& frame = m_searchstack[depth];
+    frame.trailmark = m_trail.size();
+    frame.cellindex = bestcell;
+    frame.candidates = m_core.masks[bestcell];
+
+    return true;
 }
 
-int SudokuBoard::PairSearch(Cell *cell, CellSet *set)
+void SudokuBoard::SetTrail(bool fEnable)
 {
-    // scan the entire set.  If a pair of cells are found whereby both have the same bitmask of two
-    // candidate values, then those candidate values can be erased from the rest of the cells in the set
+    m_fTrail = fEnable;
+    m_trail.clear();
+}
 
-    Cell *matchcell = NULL;
+size_t SudokuBoard::GetTrailMark() const
+{
+    return m_trail.size();
+}
 
-    if (cell->_value != 0)
-        return 0;
+void SudokuBoard::AppendTrail(int cellindex, int value, uint16_t mask)
+{
+    TrailEntry entry;
+
+    entry.cellindex = (uint8_t)cellindex;
+    entry.value = (uint8_t)value;
+    entry.mask = mask;
+
+    m_trail.push_back(entry);
+}
+
+void SudokuBoard::RollbackTrail(size_t mark)
+{
+    uint32_t dirtysets = 0;  // sets with a value taken back, their placed masks are rebuilt once at the end
+
+    assert(mark <= m_trail.size());
 
-    if (Cell::BitCount(cell->_bitmask) != 2)
+    while (m_trail.size() > mark)
     {
-        return 0;
+        const TrailEntry& entry = m_trail.back();
+        Cell *cell = GetCell(entry.cellindex);
+
+        cell->_value = entry.value;
+        cell->_bitmask = entry.mask;
+        m_core.RestoreCell(entry.cellindex, entry.value, entry.mask, dirtysets);
+
+        m_trail.pop_back();
     }
 
-    // scan the set looking for another cell with the same bitmask
-    for (int cellindex = 0; cellindex < 9; cellindex++)
+    for (int setindex : BitIndexes(dirtysets))
     {
-        Cell *othercell = set->_set[cellindex];
+        m_core.RebuildPlaced(setindex);
+    }
 
-        if (othercell == cell)
-        {
-            continue;
-        }
+    m_fSetCountsValid = false;  // the masks changed without going through ClearCandidate
+}
 
-        if (othercell->_value != 0)
-        {
-            continue;
-        }
+void SudokuBoard::SaveSnapshot(BoardSnapshot& snapshot) const
+{
+    snapshot.core = m_core;
+}
 
-        if (othercell->_bitmask == cell->_bitmask)
-        {
-            matchcell = othercell;
-            break;
-        }
+void SudokuBoard::RestoreSnapshot(const BoardSnapshot& snapshot)
+{
+    m_core = snapshot.core;
+
+    for (int cellindex = 0; cellindex < 81; cellindex++)
+    {
+        Cell *cell = GetCell(cellindex);
+        cell->_value = m_core.values[cellindex];
+        cell->_bitmask = m_core.masks[cellindex];
     }
 
-    if (matchcell == NULL)
-        return 0;
+    m_fSetCountsValid = false;  // the masks changed without going through ClearCandidate
+}
 
-    uint16_t wBitmask = matchcell->_bitmask;
 
-    int values[2];
-    values[0] = Cell::GetCellValueFromBitmaskAndClear(wBitmask);
-    values[1] = Cell::GetCellValueFromBitmaskAndClear(wBitmask);
+int SudokuBoard::ScanForSolution()
+{
+    StatsScope scope(this, m_stats.passes);
 
-    assert(values[0] != 0);
-    assert(values[1] != 0);
-    assert(wBitmask == 0);
+    // this function is the main loop that looks for a solution
+    int value = 0;
+    uint32_t startcount = m_changecount;
 
-    // remove the bitmask from all other cells in the set
-    for (int cellindex = 0; cellindex < 9; cellindex++)
+    for (int r = 0; r < 9; r++)
     {
-        Cell *othercell = set->_set[cellindex];
+        for (int c = 0; c < 9; c++)
+        {
+            Cell *cell = &m_board[r][c];
 
-        if ((othercell == matchcell) || (othercell == cell))
-            continue;
+            if (cell->_value != 0)  // cell is already solved
+            {
+                continue;
+            }
 
-        for (int x = 0; x < 2; x++)
-        {
-            if  (othercell->IsOkToSetValue(values[x]))
+            value = SimpleEliminate(cell, cell->_square);
+            if (value == 0)
+            {
+                value = SimpleEliminate(cell, cell->_row);
+            }
+            if (value == 0)
             {
-                Log("PairSearch - %d removed from cell at (r=%d c=%d)", values[x], othercell->_rowIndex, othercell->_colIndex);
-                othercell->ClearValueFromMask(values[x]);
+                value = SimpleEliminate(cell, cell->_column);
             }
         }
     }
 
-    return 0;
+    SweepNakedSubsets();
+    SweepHiddenSubsets();
+
+    SweepLockedCandidates();
+
+    //FullDump();
+    FishSearch(SET_COLUMN_BASE);
+    FishSearch(SET_ROW_BASE);
+
+    return (int)(m_changecount - startcount);
 }
 
-int SudokuBoard::TripleSearch(Cell *cell, CellSet *set)
+// SimpleEliminate looks at the non-eliminated values at "cell" and compares it to all the
+// other non-eliminated values from the {square,row,column} set.  If a non-eliminated value appears only once,
+// then it
+int SudokuBoard::SimpleEliminate(Cell *cell, CellSet *set)
 {
-    uint16_t wUnion;
-    int value;
+    StatsScope scope(this, m_stats.techniques[STAT_SIMPLE_ELIMINATE]);
+
+    int value = 0;
 
-    if(cell->_value != 0)
+    if (cell->_value != 0)
     {
         return 0;
     }
 
-    int bitcount = Cell::BitCount(cell->_bitmask);
-
-    if ((bitcount < 2) || (bitcount > 3))
+    if (PopCount(cell->_bitmask) == 1)
     {
-        return 0;                
+        // all other values have been eliminated for this cell, it must be "the one"
+        value = LowestBitIndex(cell->_bitmask) + 1;
+        SetCellValue(cell->_rowIndex, cell->_colIndex, value);
+        Trace(TECHNIQUE_NAKED_SINGLE, cell, value, TRACE_PLACED);
+        SOLVER_LOG(LOG_STEPS, "SimpleEliminate - Single Bit match.  Setting %d for (r=%d c=%d)", value, cell->_rowIndex, cell->_colIndex);
+        return value;
     }
 
-    // look for two other cells that have an intersection in bitmasks with the cell passed in
-    Cell *matches[2] = {0};
-    int matchindex = 0;
 
-    for (int index = 0; index < 9; index++)
-    {
-        Cell *othercell = set->_set[index];
-        if (othercell == cell)
-            continue;
+    // the values that appear in exactly one cell of the set are the values that no other cell in the set can hold.
+    // If the result is something that has only 1 bit set, then it follows that there is exactly one value for that cell
+    const SetCandidateCounts& counts = GetSetCandidateCounts();
+    int setindex = GetSetIndex(cell, set);
 
-        if (othercell->_value != 0)
-            continue;
+    uint16_t wResult = (cell->_bitmask & counts.once[setindex] & ~counts.twice[setindex]);
 
-        if ((othercell->_bitmask & cell->_bitmask) == 0)
-        {
-            // no intersection
-            continue;
-        }
+    if (PopCount(wResult) == 1)
+    {
+        value = LowestBitIndex(wResult) + 1;
 
-        wUnion = othercell->_bitmask | cell->_bitmask;
+        SetCellValue(cell, value);
+        Trace(TECHNIQUE_HIDDEN_SINGLE, cell, value, TRACE_PLACED);
 
-        if (Cell::BitCount(wUnion) > 3)
-        {
-            continue;
-        }
+        CELL_RELATIONSHIP relate = cell->GetRelationship(set);
 
-        matches[matchindex] = othercell;
-        matchindex++;
-        if (matchindex == 2)
-            break;
-    }
+        const char *psz = g_relationship_name[relate];
 
-    if (!(matches[0] && matches[1]))
-    {
-        return 0;
+        SOLVER_LOG(LOG_STEPS, "SimpleEliminate - setting value of %d at (r=%d c=%d) [%s elimination]", value, cell->_rowIndex, cell->_colIndex, psz);
     }
 
-    wUnion = matches[0]->_bitmask | matches[1]->_bitmask | cell->_bitmask;
-
-    // something would be "off" if we had three cells only having a union of two or less bits
-    // If the union bitmask is 4 or more, then my assertion that the loop above shouldn't do that is wrong
-    //assert(Cell::BitCount(wUnion) == 3);
+    return value;
+}
 
-    if (Cell::BitCount(wUnion) != 3)
-        return 0;
+int SudokuBoard::LockedCandidates(int intersection)
+{
+    StatsScope scope(this, m_stats.techniques[STAT_LOCKED_CANDIDATES]);
 
-    // we have our three cells, let's pull these bits out of the other cells that aren't set
+    const uint8_t *cells = g_intersectionCells[intersection];
+    uint16_t wShared = 0;      // candidates of the 3 cells the line and square share
+    uint16_t wLineRest = 0;    // candidates of the other 6 cells of the line
+    uint16_t wSquareRest = 0;  // candidates of the other 6 cells of the square
+    int removecount = 0;
 
-    for (int index = 0; index < 9; index++)
+    for (int index = 0; index < 15; index++)
     {
-        Cell *othercell = set->_set[index];
-        if (othercell == cell)
-            continue;
+        int cellindex = cells[index];
 
-        if (othercell == matches[0])
+        if (m_core.values[cellindex] != 0)
             continue;
 
-        if (othercell == matches[1])
-            continue;
+        if (index < 3)
+            wShared |= m_core.masks[cellindex];
+        else if (index < 9)
+            wLineRest |= m_core.masks[cellindex];
+        else
+            wSquareRest |= m_core.masks[cellindex];
+    }
+
+    // values the square can only hold in the shared cells (number claiming) can't go anywhere else in the line, and
+    // values the line can only hold in the shared cells (box line reduction) can't go anywhere else in the square
+    uint16_t wClaimed = wShared & ~wSquareRest & wLineRest;
+    uint16_t wReduced = wShared & ~wLineRest & wSquareRest;
+
+    if ((wClaimed | wReduced) == 0)
+        return 0;
+
+    for (int index = 3; index < 15; index++)
+    {
+        int cellindex = cells[index];
+        uint16_t wRemove = (index < 9) ? wClaimed : wReduced;
 
-        if (othercell->_value != 0)
+        if ((m_core.values[cellindex] != 0) || ((m_core.masks[cellindex] & wRemove) == 0))
             continue;
 
-        if (othercell->_bitmask & wUnion)
-        {
-            uint16_t wMask = wUnion;
+        Cell *cell = GetCell(cellindex);
 
-            while (wMask)
+        for (int value : BitValues(m_core.masks[cellindex] & wRemove))
+        {
+            if (index < 9)
             {
-                value = Cell::GetCellValueFromBitmaskAndClear(wMask);
-                if (othercell->IsOkToSetValue(value))
-                {
-                    othercell->ClearValueFromMask(value);
-                    Log("TripleSearch - %d removed from cell at (r=%d c=%d)", value, othercell->_rowIndex, othercell->_colIndex);
-                }
+                Trace(TECHNIQUE_CLAIMING, cell, value, TRACE_ELIMINATED);
+                SOLVER_LOG(LOG_STEPS, "Number Claiming - removing %d from candidate list of cell at (r=%d c=%d)", value, cell->_rowIndex, cell->_colIndex);
+            }
+            else
+            {
+                Trace(TECHNIQUE_BOX_LINE, cell, value, TRACE_ELIMINATED);
+                SOLVER_LOG(LOG_STEPS, "BoxLineReduced %d from cell(r=%d c=%d)", value, cell->_rowIndex, cell->_colIndex);
             }
+
+            ClearCandidate(cell, value);
+            removecount++;
         }
     }
 
-    return 0;
+    return removecount;
 }
 
-
-int SudokuBoard::DoXWingSets(CellSet *sets)
+int SudokuBoard::NakedSubsets(int setindex)
 {
-    // look at every row where there are exactly two candidate cells for a particular value
-    // If there is another row exactly two candidate cells for the same value, then it can be removed from the columns in the other rows
+    StatsScope scope(this, m_stats.techniques[STAT_NAKED_SUBSETS]);
 
-    int value = 0;
-    uint16_t wBitMask = 0;
-    int valuecounts[10][10] = {0}; // [row][value]
-    int col1, col2;
-    int changecount = 0;
-    bool fRet;
+    const uint8_t *cells = g_setCells[setindex];
+    uint16_t wOpen = 0;  // positions of the unsolved cells
+    int opencount = 0;
+    int removecount = 0;
 
-    for  (int rowindex = 0; rowindex < 9; rowindex++)
+    for (int index = 0; index < 9; index++)
     {
-        CellSet *row = &sets[rowindex];
-
-        for (int cellindex = 0; cellindex < 9; cellindex++)
+        if (m_core.values[cells[index]] == 0)
         {
-            Cell *cell = row->_set[cellindex];
-            if (cell->_value != 0)
-                continue;
+            wOpen |= (0x01 << index);
+            opencount++;
+        }
+    }
 
-            wBitMask = cell->_bitmask;
+    // a subset has to leave at least one unsolved cell in the set to remove candidates from
+    for (int size = 2; (size <= 4) && (size < opencount); size++)
+    {
+        // only cells with "size" candidates or fewer can be part of a subset of that size.  Number them 0 to smallcount-1
+        // so that the groups to try are the first ones in g_positionGroups
+        int smallcells[9];
+        int smallcount = 0;
 
-            while (wBitMask)
+        for (int index : BitIndexes(wOpen))
+        {
+            if (PopCount(m_core.masks[cells[index]]) <= size)
             {
-                value = Cell::GetCellValueFromBitmaskAndClear(wBitMask);
-                valuecounts[rowindex][value] = valuecounts[rowindex][value] + 1;
+                smallcells[smallcount++] = cells[index];
             }
         }
-    }
-
-    // for each row, look for instances where there are only two possible cells for a given instance
 
-    for (int rowindex = 0; rowindex < 9; rowindex++)
-    {
-        for (int valueindex = 1; valueindex <= 9; valueindex++)
+        for (int group = g_positionGroupStart[size]; group < g_positionGroupStart[size + 1]; group++)
         {
-            if (valuecounts[rowindex][valueindex] == 2)
+            uint16_t wGroup = g_positionGroups[group];
+
+            if ((wGroup >> smallcount) != 0)
+                break;
+
+            uint16_t wUnion = 0;
+            for (int index : BitIndexes(wGroup))
             {
+                wUnion |= m_core.masks[smallcells[index]];
+            }
 
-                fRet = XWing_FindColumnIndices(&sets[rowindex], valueindex, col1, col2);
-                if (fRet == false)
-                    continue;
-              
+            // fewer values than cells is a contradiction, not a subset
+            if (PopCount(wUnion) != size)
+                continue;
 
-                // find the matching row
-                CellSet *matchrow = NULL;
-                for (int nextrowindex = rowindex+1; nextrowindex < 9; nextrowindex++)
-                {
-                    if (valuecounts[nextrowindex][valueindex] == 2)
-                    {
-                        matchrow = &sets[nextrowindex];
-
-                        Cell *c1 = matchrow->_set[col1];
-                        Cell *c2 = matchrow->_set[col2];
-
-                        if (!(c1->IsOkToSetValue(valueindex) && c2->IsOkToSetValue(valueindex)))
-                        {
-                            matchrow = NULL;
-                        }
-                        else
-                        {
-                            break;
-                        }
-                    }
-                }
+            // the cells of the group hold these values between them, so no other cell in the set can
+            for (int index : BitIndexes(wOpen))
+            {
+                int cellindex = cells[index];
+                uint16_t wRemove = m_core.masks[cellindex] & wUnion;
+
+                if ((wRemove == 0) || ((m_core.masks[cellindex] & ~wUnion) == 0))
+                    continue;  // nothing to remove, or the cell is one of the group
 
+                Cell *othercell = GetCell(cellindex);
 
-                if (matchrow != NULL)
+                for (int value : BitValues(wRemove))
                 {
-                    changecount = XWing_DoFilter(sets, &sets[rowindex], matchrow, valueindex, col1, col2);
+                    Trace(TECHNIQUE_NAKED_SUBSET, othercell, value, TRACE_ELIMINATED);
+                    SOLVER_LOG(LOG_STEPS, "NakedSubset - %d removed from cell at (r=%d c=%d)", value, othercell->_rowIndex, othercell->_colIndex);
+                    ClearCandidate(othercell, value);
+                    removecount++;
                 }
             }
         }
     }
 
-    return changecount;
+    return removecount;
 }
 
-bool SudokuBoard::XWing_FindColumnIndices(CellSet *row, int value, int &col1, int &col2)
+
+int SudokuBoard::HiddenSubsets(int setindex)
 {
-    col1 = -1;
-    col2 = -1;
+    StatsScope scope(this, m_stats.techniques[STAT_HIDDEN_SUBSETS]);
 
-    for (int cellindex = 0; cellindex < 9; cellindex++)
-    {
-        Cell *cell = row->_set[cellindex];
+    const uint8_t *cells = g_setCells[setindex];
+    const uint16_t *positions = m_core.positions[setindex];
+    uint16_t wOpen = 0;  // positions of the unsolved cells
+    int opencount = 0;
+    int removecount = 0;
 
-        if (cell->IsOkToSetValue(value))
+    for (int index = 0; index < 9; index++)
+    {
+        if (m_core.values[cells[index]] == 0)
         {
-            if (col1 == -1)
-                col1 = cellindex;
-            else if (col2 == -1)
-                col2 = cellindex;
-            else
-                assert(false);  // a third instance found in this row???
+            wOpen |= (0x01 << index);
+            opencount++;
         }
     }
 
-    if ((col1 == -1) || (col2 == -1))
+    // a subset has to leave at least one unsolved cell in the set for the other values
+    for (int size = 2; (size <= 4) && (size < opencount); size++)
     {
-        // this can happen if a previous loop in DoXWingSets removed one of the values
-        return false;
+        // only values with "size" places or fewer left can be part of a subset of that size.  Number them 0 to smallcount-1
+        // so that the groups to try are the first ones in g_positionGroups
+        int smallvalues[9];
+        int smallcount = 0;
+
+        for (int value : BitValues(CELLINIT & ~m_core.placed[setindex]))
+        {
+            if (PopCount(positions[value - 1] & wOpen) <= size)
+            {
+                smallvalues[smallcount++] = value;
+            }
+        }
+
+        for (int group = g_positionGroupStart[size]; group < g_positionGroupStart[size + 1]; group++)
+        {
+            uint16_t wGroup = g_positionGroups[group];
+
+            if ((wGroup >> smallcount) != 0)
+                break;
+
+            uint16_t wValues = 0;
+            uint16_t wUnion = 0;
+            for (int index : BitIndexes(wGroup))
+            {
+                wValues |= (0x01 << (smallvalues[index] - 1));
+                wUnion |= positions[smallvalues[index] - 1];
+            }
+            wUnion &= wOpen;
+
+            // fewer places than values is a contradiction, not a subset
+            if (PopCount(wUnion) != size)
+                continue;
+
+            // these values can only go in these cells, so the cells can't hold anything else
+            for (int index : BitIndexes(wUnion))
+            {
+                Cell *cell = GetCell(cells[index]);
+
+                for (int value : BitValues(cell->_bitmask & ~wValues))
+                {
+                    Trace(TECHNIQUE_HIDDEN_SUBSET, cell, value, TRACE_ELIMINATED);
+                    SOLVER_LOG(LOG_STEPS, "HiddenSubset - %d removed from cell at (r=%d c=%d)", value, cell->_rowIndex, cell->_colIndex);
+                    ClearCandidate(cell, value);
+                    removecount++;
+                }
+            }
+        }
     }
-    return true;
+
+    return removecount;
 }
 
-int SudokuBoard::XWing_DoFilter(CellSet *sets, CellSet *firstrow, CellSet *matchrow, int value, int col1, int col2)
+
+int SudokuBoard::FishSearch(int basesetindex)
 {
-    int changecount = 0;
+    StatsScope scope(this, m_stats.techniques[STAT_FISH]);
 
-    bool fUsingColumns = (firstrow->_set[0]->_rowIndex == matchrow->_set[0]->_rowIndex);
+    static const char *fishname[5] = { "", "", "XWing", "Swordfish", "Jellyfish" };
 
-    for (int rowindex = 0; rowindex < 9; rowindex++)
+    // the cover sets are the columns when the base sets are the rows and the other way around.  positions[] of a row
+    // is indexed by column and positions[] of a column by row, so the positions of one are the line numbers of the other
+    int coversetindex = (basesetindex == SET_ROW_BASE) ? SET_COLUMN_BASE : SET_ROW_BASE;
+    int removecount = 0;
+
+    for (int value = 1; value <= 9; value++)
     {
-        CellSet  *row = &sets[rowindex];
+        uint16_t wValue = (uint16_t)(0x01 << (value - 1));
+        int counts[9];
+        int opencount = 0;
 
-        if ((row == firstrow) || (row == matchrow))
+        for (int line = 0; line < 9; line++)
         {
-            continue;
+            counts[line] = 0;
+            if ((m_core.placed[basesetindex + line] & wValue) == 0)
+            {
+                counts[line] = PopCount(m_core.positions[basesetindex + line][value - 1]);
+                opencount++;
+            }
         }
 
-        // now look at col1 and col2 to see if value appears in the candidate list for these cells
+        // N base lines that make a fish leave the other cover lines with the value only in the other base lines, which
+        // is a fish of (opencount - N) lines the other way.  Both ways are searched, so only the smaller half is needed here
+        for (int size = 2; (size <= 4) && (size * 2 <= opencount); size++)
+        {
+            // base lines that still need the value and have 2 to "size" places left for it.  Number them 0 to basecount-1
+            // so that the groups to try are the first ones in g_positionGroups
+            int baselines[9];
+            int basecount = 0;
 
-        Cell *cells[2];
-        
-        cells[0] = row->_set[col1];
-        cells[1] = row->_set[col2];
+            for (int line = 0; line < 9; line++)
+            {
+                if ((counts[line] >= 2) && (counts[line] <= size))
+                {
+                    baselines[basecount++] = line;
+                }
+            }
 
-        for (int x = 0; x < 2; x++)
-        {
-            if (cells[x]->IsOkToSetValue(value))
+            for (int group = g_positionGroupStart[size]; group < g_positionGroupStart[size + 1]; group++)
             {
-                Log("XWing - removing %d from cell at (r=%d c=%d)", value, cells[x]->_rowIndex, cells[x]->_colIndex);
+                uint16_t wGroup = g_positionGroups[group];
+
+                if ((wGroup >> basecount) != 0)
+                    break;
 
-                if (fUsingColumns == false)
+                uint16_t wBase = 0;
+                uint16_t wCover = 0;
+                for (int index : BitIndexes(wGroup))
                 {
-                    Log("   XWing cells are at (r=%d c=%d) (r=%d c=%d) (r=%d c=%d) (r=%d c=%d)", firstrow->_set[0]->_rowIndex, col1, firstrow->_set[0]->_rowIndex, col2, matchrow->_set[0]->_rowIndex, col1, matchrow->_set[0]->_rowIndex, col2);
+                    wBase |= (0x01 << baselines[index]);
+                    wCover |= m_core.positions[basesetindex + baselines[index]][value - 1];
                 }
-                else
+
+                // fewer cover lines than base lines is a contradiction, not a fish
+                if (PopCount(wCover) != size)
+                    continue;
+
+                // each base line puts the value in one of the cover lines, so that fills every cover line and
+                // the value can't go anywhere else in them
+                for (int coverline : BitIndexes(wCover))
                 {
-                    Log("   XWing cells are at (r=%d c=%d) (r=%d c=%d) (r=%d c=%d) (r=%d c=%d)", col1, firstrow->_set[0]->_colIndex, col1, matchrow->_set[0]->_colIndex, col2, firstrow->_set[0]->_colIndex, col2, matchrow->_set[0]->_colIndex);
-                }
+                    int setindex = coversetindex + coverline;
 
+                    for (int line : BitIndexes(m_core.positions[setindex][value - 1] & ~wBase))
+                    {
+                        int cellindex = g_setCells[setindex][line];
+
+                        if (m_core.values[cellindex] != 0)
+                            continue;
 
-                cells[x]->ClearValueFromMask(value);
-                changecount++;
+                        Cell *cell = GetCell(cellindex);
+                        Trace(TECHNIQUE_FISH, cell, value, TRACE_ELIMINATED);
+                        SOLVER_LOG(LOG_STEPS, "%s - removing %d from cell at (r=%d c=%d)", fishname[size], value, cell->_rowIndex, cell->_colIndex);
+                        ClearCandidate(cell, value);
+                        removecount++;
+                    }
+                }
             }
         }
     }
 
-    return changecount;
+    return removecount;
 }
 
 
-
-
-
-
 void SudokuBoard::Dump()
 {
     for (int row = 0; row < 9; row++)
@@ -1012,14 +1660,11 @@ void SudokuBoard::FullDump()
             else
             {
                 LogWithoutLineBreak("{");
-                uint16_t wMask = m_board[row][col]._bitmask;
-                count = 0;
-                while (wMask)
+                for (int candidate : BitValues(m_board[row][col]._bitmask))
                 {
-                    value = Cell::GetCellValueFromBitmaskAndClear(wMask);
-                    LogWithoutLineBreak("%c", value + '0');
-                    count++;
+                    LogWithoutLineBreak("%c", candidate + '0');
                 }
+                count = PopCount(m_board[row][col]._bitmask);
 
                 int remainingspaces = 5 - count;
                 LogWithoutLineBreak("}");
@@ -1044,6 +1689,3 @@ void SudokuBoard::FullDump()
 
     }
 }
-
-
-
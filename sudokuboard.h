@@ -18,6 +18,62 @@
 
 
 #include "cell.h"
+#include "boardcore.h"
+#include "setcounts.h"
+#include "loglevel.h"
+#include "solvetrace.h"
+#include "solvestats.h"
+
+enum SOLVE_ENGINE
+{
+    ENGINE_SCAN,       // every pass is a full ScanForSolution sweep over all the cells and sets
+    ENGINE_PROPAGATE,  // naked and hidden singles are driven by a work queue of changed cells and sets
+    ENGINE_ADAPTIVE    // singles as in ENGINE_PROPAGATE, then the other algorithms are tried cheapest first until one makes progress
+};
+
+enum SOLVE_STATUS
+{
+    STATUS_SOLVED,    // every cell has a value and no value is repeated in a row, column, or square
+    STATUS_STALLED,   // the board isn't solved but no contradiction was found
+    STATUS_INVALID    // the board has no solution (a repeated value, a contradiction, or a search that found nothing)
+};
+
+// SolveResult is the outcome of a call to Solve, in a form that doesn't need any parsing
+struct SolveResult
+{
+    char grid[82];        // the 81 cell values as '1'-'9', '.' for unsolved cells, null terminated
+    SOLVE_STATUS status;
+    int scancount;        // number of passes made by the logic engine
+    bool fValid;          // no value is repeated in a row, column, or square
+    bool fSearched;       // the search fallback was needed
+};
+
+// A BoardSnapshot is the mutable state of a SudokuBoard: a copy of its BoardCore, which is the value and candidate list
+// of every cell plus the per-set tables kept from them, about 1.4 KB in all.  It has no pointers, so it can be saved,
+// copied, and restored on any board without allocating.  Use it to try something on a board (a guess, a hint) and put
+// the board back afterwards.  To take back a few changes at a time, the undo trail (SetTrail) copies much less.
+// The permanent flags of the initial values are not included, they only change when a puzzle is loaded.
+struct BoardSnapshot
+{
+    BoardCore core;
+};
+
+// One entry of the undo trail: the value and candidate list a cell had before it was changed
+struct TrailEntry
+{
+    uint8_t cellindex;
+    uint8_t value;
+    uint16_t mask;
+};
+
+// A SearchFrame is one level of the backtracking search.  It holds the trail mark from before the guess
+// so that the next candidate value can be tried from the same starting point.
+struct SearchFrame
+{
+    size_t trailmark;     // end of the undo trail before guessing
+    int cellindex;        // cell being guessed
+    uint16_t candidates;  // values that have not been tried yet for the cell
+};
 
 class SudokuBoard
 {
@@ -26,18 +82,89 @@ public:
 
     bool Init();
 
+    // Reset puts the board back to the state Init leaves it in, ready to load the next puzzle.  The links between
+    // the cells and the rows, columns, and squares never change after Init, so Reset only clears the values,
+    // candidate lists, and permanent flags of the cells and resets the BoardCore.
+    void Reset();
+
     bool LoadFromFile(const std::string& filename);
 
+    // LoadFromBuffer parses a board from memory using the same rules as LoadFromFile.  Whitespace is skipped,
+    // digits 1-9 are initial values, and any other character (such as '.' or '0') is an unsolved cell.
+    // Returns false if the buffer holds fewer than 81 cells, or anything but whitespace after the 81st.  Nothing is logged.
+    // Like LoadFromFile, the board must be new or have had Init or Reset called.
+    bool LoadFromBuffer(const char *buffer, size_t length);
+
+    // LoadFromString is LoadFromBuffer for a string
+    bool LoadFromString(const std::string& puzzle);
+
     std::string GetBoardState();
 
+    // GetBoardLine writes the 81 cell values as a single line of text with '.' for unsolved cells.
+    // pszLine must have room for 82 chars (81 cells plus the null terminator)
+    void GetBoardLine(char *pszLine);
+
+    // Sets how much Solve and the solving algorithms log.  The default is LOG_DUMPS (everything)
+    void SetLogLevel(LOG_LEVEL level);
+
+    // When tracing is on, Solve records every deduction in a SolveTrace (off by default).  GetTrace returns the
+    // events from the last call to Solve
+    void SetTracing(bool fEnable);
+    const SolveTrace& GetTrace() const;
+
+    // When stats are on, Solve counts the calls, hits, removed candidates, placed values, and time of every solving
+    // algorithm and solve pass (off by default).  GetStats returns the counts from the last call to Solve
+    void SetStats(bool fEnable);
+    const SolveStats& GetStats() const;
+
+    // Selects how Solve looks for a solution.  The default is ENGINE_SCAN
+    void SetEngine(SOLVE_ENGINE engine);
+
+    // When the search fallback is on, Solve finishes any board that the logic algorithms can't by guessing (off by default)
+    void SetSearchFallback(bool fEnable);
+
+    // CountSolutions counts the solutions of the board as it stands (initial values plus whatever candidates have
+    // already been eliminated), stopping as soon as "limit" solutions are found.  A limit of 2 is enough to tell
+    // whether a puzzle has no solution, exactly one, or more than one.  A limit of 0 counts every solution.
+    // The board is left unchanged and nothing is logged, traced, or counted in the stats.
+    int CountSolutions(int limit);
+
     bool Solve();
 
+    // Solve with the result filled in.  Nothing is logged regardless of the log level, so this overload never
+    // writes to stdout.  Returns true if the board was solved
+    bool Solve(SolveResult& result);
+
+    // IsSolved (every cell has a value) and IsValid (no value repeated in a row, column, or square) read counters that
+    // are kept up to date as values are placed, so they cost the same at any point of a solve
     bool IsSolved();
     bool IsValid();
 
+    // true if a cell has no candidates left or a value has no place left in a row, column, or square.  The board can't be
+    // solved from here.  Like IsSolved, this is a counter check.
+    bool HasContradiction() const;
+
     void Dump();
     void FullDump();
 
+    // flat copy of the board state, kept in sync with the cells
+    const BoardCore& GetCore() const;
+
+    // returns true if the core matches the cells.  It rebuilds a whole BoardCore, so it is for tests, not for Solve
+    bool IsCoreInSync();
+
+    // SaveSnapshot copies the values and candidate lists of the board into "snapshot".  RestoreSnapshot puts them back.
+    // A snapshot taken from one board can be restored on another
+    void SaveSnapshot(BoardSnapshot& snapshot) const;
+    void RestoreSnapshot(const BoardSnapshot& snapshot);
+
+    // When the trail is on, every value placed and every candidate removed appends the old state of the cell to an
+    // undo trail.  GetTrailMark returns the current end of the trail, and RollbackTrail undoes every change made
+    // since a mark, newest first.  Turning the trail on or off, Init, and Reset all empty the trail (off by default)
+    void SetTrail(bool fEnable);
+    size_t GetTrailMark() const;
+    void RollbackTrail(size_t mark);
+
 
 
 protected:
@@ -46,15 +173,122 @@ protected:
     CellSet m_rows[9];
     CellSet m_cols[9];
 
+    // m_core mirrors the value and candidate list of every cell.  SetCellValue and ClearCandidate keep it up to date.
+    BoardCore m_core;
+
+    // m_changecount goes up by one for every value placed and every candidate removed from a cell.
+    // Comparing it before and after a pass tells if the pass made any progress.
+    uint32_t m_changecount;
+    uint32_t m_placedcount;     // the part of m_changecount that is values placed
+    uint32_t m_peerclearcount;  // the part of m_changecount that is candidates removed from the peers of a placed value
+
+    // candidate counts for all 27 sets, recounted by GetSetCandidateCounts when m_changecount moves past m_setcountsversion
+    SetCandidateCounts m_setcounts;
+    uint32_t m_setcountsversion;
+    bool m_fSetCountsValid;
+
+    SOLVE_ENGINE m_engine;
+
+    // outcome of the last call to Solve
+    int m_scancount;
+    SOLVE_STATUS m_status;
+    bool m_fSearched;
+
+    // Work queue for ENGINE_PROPAGATE.  Items 0-80 are cells (by _cellIndex) and items 81-107 are sets
+    // (81 plus the BoardCore set index).  An item is only ever in the queue once, so the ring buffer can't overflow.
+    // While m_fQueueing is set, SetCellValue and ClearCandidate queue every cell that changes and the sets it belongs to.
+    static const int QUEUE_SIZE = 81 + 27;
+    bool m_fQueueing;
+    int m_queuehead;
+    int m_queuecount;
+    uint8_t m_queue[QUEUE_SIZE];
+    bool m_queued[QUEUE_SIZE];
+
+    // Backtracking search.  Every guess places at least one value, so the search can never be more than 81 deep
+    bool m_fSearch;
+    SearchFrame m_searchstack[81];
+
+    // Undo trail.  SetCellValue and ClearCandidate append to it while m_fTrail is set.  Along one line of play a cell
+    // can only lose each candidate once and get a value once, so TRAIL_RESERVE entries is enough for a whole solve
+    // plus a search on top of it, and the trail doesn't allocate once the board is constructed.
+    static const int TRAIL_RESERVE = 2 * (81 + 729);
+    bool m_fTrail;
+    std::vector<TrailEntry> m_trail;
+
+    void AppendTrail(int cellindex, int value, uint16_t mask);  // records the state of a cell from before a change
+
     // ScanForSolution will do one full pass on the on the board
     // It will attempt to assign values to cells and eliminate values from the candidate list of each cell
-    void ScanForSolution();
+    // Returns the number of changes (values placed plus candidates removed) made during the pass
+    int ScanForSolution();
 
     // SetCellValue will set the value at the specified cell.  It will also clear out the value from other cells that are
     // in the same area (row, column, square) as this cell
     void SetCellValue(int row, int col, int value, bool fPerm=false);
     void SetCellValue(Cell *cell, int value, bool fPerm=false);
 
+    Cell *GetCell(int cellindex);  // cellindex is 0-80
+    int GetSetIndex(Cell *cell, CellSet *set);  // BoardCore index of one of the sets "cell" belongs to
+
+    const SetCandidateCounts& GetSetCandidateCounts();
+
+    // ClearCandidate removes a value from the candidate list of a cell and counts the change.  All of the
+    // solving algorithms remove candidates through this function rather than calling Cell::ClearValueFromMask directly.
+    // Returns true if the value was in the candidate list
+    bool ClearCandidate(Cell *cell, int value);
+
+    // Work queue helpers for ENGINE_PROPAGATE
+    void StartQueueing();   // queues every cell and set and turns on queueing
+    void StopQueueing();    // turns off queueing and empties the queue
+    void ClearQueue();
+    void QueueCell(Cell *cell);  // queues the cell and its row, column, and square
+    void QueueItem(int item);
+
+    // PropagateSingles works through the queue until it is empty.  A queued cell with one candidate left gets that value
+    // (naked single).  A queued set with a candidate value that only one of its cells can hold gets that value placed (hidden single).
+    // Placing a value queues the cells it removes candidates from, so singles keep propagating without rescanning the board.
+    // Returns false if a contradiction is found (a cell with no candidates or a value with no place left in a set)
+    bool PropagateSingles();
+    bool PropagateSet(int setindex);
+
+    // PropagationPass is one pass of ENGINE_PROPAGATE.  Singles are propagated first. If that doesn't solve the board,
+    // the elimination algorithms (everything in ScanForSolution except SimpleEliminate) are run once.
+    // Returns the number of changes made, or -1 if a contradiction was found
+    int PropagationPass();
+    void ScanForEliminations();
+
+    // AdaptivePass is one pass of ENGINE_ADAPTIVE.  Singles are propagated first, then the sweeps in s_schedule are
+    // run in order until one of them changes the board.  The next pass starts over with singles, so the expensive
+    // algorithms only run when everything cheaper has stalled.  Every algorithm only removes candidates that
+    // can't be part of the solution, so the board ends up in the same state as with ENGINE_SCAN, just with less work.
+    // Returns the number of changes made, or -1 if a contradiction was found
+    int AdaptivePass();
+
+    // Each sweep runs one algorithm over the whole board and returns the number of changes made
+    typedef int (SudokuBoard::*TechniqueSweep)();
+    static const TechniqueSweep s_schedule[];
+    static const int SCHEDULE_SIZE;
+
+    int SweepLockedCandidates();  // LockedCandidates on every intersection
+    int SweepNakedSubsets();      // NakedSubsets on every square, row, and column
+    int SweepHiddenSubsets();     // HiddenSubsets on every set
+    int SweepFish();              // FishSearch on the columns and then the rows
+
+    // Search is a depth first search that starts from whatever state the logic algorithms left the board in.
+    // It guesses a value for the unsolved cell with the fewest candidates and propagates singles after every guess.
+    // A contradiction backs up to the last guess and tries its next value.  The search stack is m_searchstack, so the
+    // search does no heap allocation.  Returns true if a solution was found.  Otherwise the board is left as it was.
+    bool Search();
+
+    // SearchSolutions is the search loop behind Search and CountSolutions.  It stops when "limit" solutions have been
+    // found and leaves the last one on the board.  If the search runs out first, the board is put back the way it was.
+    // Returns the number of solutions found.  guesscount is incremented for every guess.
+    int SearchSolutions(int limit, int& guesscount);
+
+    // PushSearchFrame picks the cell to guess at "depth" and saves the board state in m_searchstack[depth].
+    // Returns false if there is an unsolved cell with no candidates left
+    bool PushSearchFrame(int depth);
+
 
     // the following are individual algorithms for solving
 
@@ -62,36 +296,61 @@ protected:
     // or contains a candidate value that doesn't appear anywhere else in the set, then that value gets assigned to the cell
     int SimpleEliminate(Cell *cell, CellSet *set);
 
-    // PairSearch will evaluate "cell" if it only has two candidate values.  If it does, it will try to find another cell
-    // in "set" that has the same pair of candidate values.  If it finds a match, the seven other cells in "set" have the two candidate
-    // values removed
-    int PairSearch(Cell *cell, CellSet *set);
+    // NakedSubsets looks for N unsolved cells in set "setindex" (N is 2, 3, or 4) whose candidate lists hold only N values
+    // between them.  Those N values have to go in those N cells, so they are removed from the candidate lists of the other cells
+    // in the set.  The groups of cells are walked from the g_positionGroups table, skipping any group with a cell that has
+    // more than N candidates.
+    int NakedSubsets(int setindex);
+
+    // HiddenSubsets is the other side of NakedSubsets.  It looks for N values (N is 2, 3, or 4) that between them only have
+    // N places left in a set (setindex is numbered as in boardcore.h).  Those N cells have to hold those N values, so every
+    // other candidate is removed from them.  The places of each value come from BoardCore::positions.
+    int HiddenSubsets(int setindex);
+
+
+    // LockedCandidates looks at one of the 54 places where a row or column crosses a square (see g_intersectionCells).
+    // If the square can only hold a value in the 3 shared cells, the value is removed from the rest of the line (number claiming).
+    // If the line can only hold a value in the shared cells, the value is removed from the rest of the square (box line reduction).
+    // Both come from the candidate unions of the shared cells and the two remainders, for all nine values at once.
+    int LockedCandidates(int intersection);
 
+    // FishSearch looks for X-Wings (N=2), Swordfish (N=3), and Jellyfish (N=4).  If the places left for a value in N rows
+    // all fall in the same N columns, then those N columns have their value in those N rows, and the value is removed from the
+    // other cells of the columns.  basesetindex is SET_ROW_BASE to look at rows (removing from columns) or SET_COLUMN_BASE for
+    // the other way around.  The places come from BoardCore::positions, which hold a 9x9 bitboard per value.
+    int FishSearch(int basesetindex);
 
-    // TripleSearch works just like PairSearch except it looks for 3 candidate values across three sells in the same set
-    int TripleSearch(Cell *cell, CellSet *set);
+    LOG_LEVEL m_loglevel;
 
+    bool m_fTracing;
+    SolveTrace m_trace;
 
-    // BoxLineReduction takes a row or column set as a parameter
-    // This function will determine what values are missing from this row or column.
-    // For each missing value in "set", it will detemine if all the candidate cells for this value lie in the same box.
-    // If so, it will remove the value from the candidate list of cells in this SQUARE that do not belong to this set (row/column)
-    int BoxLineReduction(CellSet *set); // set must not be a square - rows or columns only
+    bool m_fStats;
+    SolveStats m_stats;
 
+    // A StatsScope adds one call of a solving algorithm (or one solve pass) to a set of counters in m_stats.
+    // It is declared at the top of the function and counts everything the board changes until it goes out of scope.
+    // It does nothing when stats are off.
+    class StatsScope
+    {
+    public:
+        StatsScope(SudokuBoard *board, TechniqueCounters& counters);
+        ~StatsScope();
 
-    // DoNumberClaiming
-    // if a candidate value appears in only 1 row/column of a square, then it can be eliminated from the candidate
-    // lists of the cells in the same row/column outside the square
-    int DoNumberClaiming(CellSet *set);
-    int ClaimNumbers(uint16_t mask, CellSet *square, CellSet *set);
+    private:
+        SudokuBoard *m_board;
+        TechniqueCounters *m_counters;
+        uint32_t m_changecount;
+        uint32_t m_placedcount;
+        uint32_t m_peerclearcount;
+        std::chrono::steady_clock::time_point m_start;
+    };
 
-    // XWing pairs are tricky.  If a value appears in the candidate lists of exactly two cells of a given row and there is
-    // another row with the two cells holding the candidate value in the same two columns, then other columns on other rows have this value eliminated
-    // from the candidate list.
-    int DoXWingSets(CellSet *sets); // all the rows or all the columns
-    bool XWing_FindColumnIndices(CellSet *row, int value, int &col1, int &col2);
-    int XWing_DoFilter(CellSet *sets, CellSet *firstrow, CellSet *matchrow, int value, int col1, int col2);
+    // Trace records one deduction in m_trace if tracing is on
+    void Trace(TRACE_TECHNIQUE technique, Cell *cell, int value, TRACE_ACTION action);
 
+    // Log and LogWithoutLineBreak write unconditionally unless the level is LOG_OFF.  Use SOLVER_LOG for anything
+    // that should depend on the level, so that the arguments aren't formatted when it is too low.
     void LogWithoutLineBreak(const char *pszFormat, ...);
     void Log(const char *pszFormat, ...);
 
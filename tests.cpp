@@ -0,0 +1,468 @@
+/*
+    Copyright 2017 John Selbie
+    Licensed under the Apache License, Version 2.0 (the "License");
+    you may not use this file except in compliance with the License.
+    You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+    Unless required by applicable law or agreed to in writing, software
+    distributed under the License is distributed on an "AS IS" BASIS,
+    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+    See the License for the specific language governing permissions and
+    limitations under the License.
+*/
+
+// tests is a separate executable from the solver app.  It checks the behavior of the in-memory API that isn't visible
+// from the sample puzzles: results for boards that are loaded full, buffers that aren't one puzzle, and so on.
+// Every failed check prints a line, and the exit code is the number of failed checks.
+
+#include "stdafx.h"
+#include "sudokuboard.h"
+#include "bitops.h"
+
+static int g_failures = 0;
+
+#define TEST_CHECK(expr) \
+    do { if (!(expr)) { std::cout << __FILE__ << ":" << __LINE__ << ": check failed: " << #expr << std::endl; g_failures++; } } while (0)
+
+// a valid solution grid, and the same grid with the last two values swapped so that 9 and 3 are each repeated in a column
+static const char *g_solvedGrid =    "417369825632158947958724316825437169791586432346912758289643571573291684164875293";
+static const char *g_duplicateGrid = "417369825632158947958724316825437169791586432346912758289643571573291684164875239";
+
+// input.txt on one line, the logic solves it
+static const char *g_inputPuzzle = "9.63.51....5....4....9....6..1.24....8.5.3.6....16.9..3....7....1....8....24.16.3";
+
+// a 17 clue puzzle that the logic can't finish without guessing
+static const char *g_hardPuzzle = ".......124...9...........5..7.2.....6.....4.....1.8....18..........3.7..5.2......";
+
+// TestBoard opens up the solving techniques so that each one can be run by itself on a position built by hand
+class TestBoard : public SudokuBoard
+{
+public:
+    using SudokuBoard::NakedSubsets;
+    using SudokuBoard::HiddenSubsets;
+    using SudokuBoard::FishSearch;
+    using SudokuBoard::LockedCandidates;
+
+    // removes every candidate of the cell that isn't in wKeep
+    void KeepCandidates(int cellindex, uint16_t wKeep)
+    {
+        for (int value : BitValues(GetCore().masks[cellindex] & ~wKeep))
+        {
+            ClearCandidate(GetCell(cellindex), value);
+        }
+    }
+};
+
+// candidate mask of a list of values
+static uint16_t ValueMask(std::initializer_list<int> values)
+{
+    uint16_t mask = 0;
+    for (int value : values)
+    {
+        mask |= (0x01 << (value - 1));
+    }
+    return mask;
+}
+
+// the number of cells whose candidates are not before.masks[] minus removed[]
+static int CountUnexpectedMasks(const BoardCore& before, const BoardCore& after, const uint16_t removed[81])
+{
+    int count = 0;
+    for (int cellindex = 0; cellindex < 81; cellindex++)
+    {
+        if (after.masks[cellindex] != (before.masks[cellindex] & ~removed[cellindex]))
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+static void TestFilledValidGrid()
+{
+    SudokuBoard board;
+    SolveResult result;
+
+    board.SetLogLevel(LOG_OFF);
+
+    TEST_CHECK(board.LoadFromString(g_solvedGrid));
+    TEST_CHECK(board.Solve(result));
+    TEST_CHECK(result.status == STATUS_SOLVED);
+    TEST_CHECK(result.fValid);
+    TEST_CHECK(strcmp(result.grid, g_solvedGrid) == 0);
+}
+
+static void TestFilledDuplicateGrid()
+{
+    SudokuBoard board;
+    SolveResult result;
+
+    board.SetLogLevel(LOG_OFF);
+
+    TEST_CHECK(board.LoadFromString(g_duplicateGrid));
+    TEST_CHECK(board.Solve(result) == false);
+    TEST_CHECK(result.status == STATUS_INVALID);
+    TEST_CHECK(result.fValid == false);
+
+    board.Reset();
+    TEST_CHECK(board.LoadFromString(g_duplicateGrid));
+    TEST_CHECK(board.Solve() == false);
+    TEST_CHECK(board.IsValid() == false);
+}
+
+static void TestBufferLength()
+{
+    SudokuBoard board;
+    std::string puzzle = g_hardPuzzle;
+
+    TEST_CHECK(board.LoadFromString(puzzle));
+
+    board.Reset();
+    TEST_CHECK(board.LoadFromString(puzzle + " \t\r\n"));
+
+    board.Reset();
+    TEST_CHECK(board.LoadFromString(puzzle.substr(0, 80)) == false);
+
+    board.Reset();
+    TEST_CHECK(board.LoadFromString(puzzle + ".") == false);
+
+    board.Reset();
+    TEST_CHECK(board.LoadFromString(puzzle + "  5") == false);
+}
+
+static void TestResetMatchesNewBoard()
+{
+    SudokuBoard board;
+    SudokuBoard fresh;
+    SolveResult result;
+    SolveResult freshresult;
+
+    board.SetLogLevel(LOG_OFF);
+    fresh.SetLogLevel(LOG_OFF);
+
+    TEST_CHECK(board.LoadFromString(g_hardPuzzle));
+    board.SetSearchFallback(true);
+    TEST_CHECK(board.Solve(result));
+
+    // a reset board holds exactly what a new one does, so the next puzzle solves the same way
+    board.Reset();
+    TEST_CHECK(board.GetCore().IsEqual(fresh.GetCore()));
+
+    board.SetSearchFallback(false);
+    TEST_CHECK(board.LoadFromString(g_inputPuzzle));
+    TEST_CHECK(fresh.LoadFromString(g_inputPuzzle));
+    TEST_CHECK(board.Solve(result));
+    TEST_CHECK(fresh.Solve(freshresult));
+    TEST_CHECK(strcmp(result.grid, freshresult.grid) == 0);
+    TEST_CHECK(board.GetCore().IsEqual(fresh.GetCore()));
+}
+
+static void TestCountSolutionsKeepsTrail()
+{
+    SudokuBoard board;
+    BoardSnapshot before;
+
+    board.SetLogLevel(LOG_OFF);
+    board.SetTrail(true);
+
+    // only 9 clues, so the count stops at the limit in the middle of the search
+    TEST_CHECK(board.LoadFromString("1........2........3........4........5........6........7........8........9........"));
+    size_t mark = board.GetTrailMark();
+    board.SaveSnapshot(before);
+
+    TEST_CHECK(board.CountSolutions(2) == 2);
+    TEST_CHECK(board.GetTrailMark() == mark);
+    TEST_CHECK(board.GetCore().IsEqual(before.core));
+
+    // rolling back the load still works after the count
+    board.RollbackTrail(0);
+    TEST_CHECK(board.GetCore().IsEqual(SudokuBoard().GetCore()));
+}
+
+static void TestRollbackToMiddleOfSolve()
+{
+    SudokuBoard board;
+    BoardSnapshot loaded;
+    BoardSnapshot stalled;
+
+    board.SetLogLevel(LOG_OFF);
+    board.SetTrail(true);
+
+    TEST_CHECK(board.LoadFromString(g_hardPuzzle));
+    size_t loadmark = board.GetTrailMark();
+    board.SaveSnapshot(loaded);
+
+    // the logic alone stalls partway, which leaves a mark in the middle of the whole solve
+    TEST_CHECK(board.Solve() == false);
+    size_t stallmark = board.GetTrailMark();
+    board.SaveSnapshot(stalled);
+    TEST_CHECK(stallmark > loadmark);
+
+    board.SetSearchFallback(true);
+    TEST_CHECK(board.Solve());
+    TEST_CHECK(board.GetTrailMark() > stallmark);
+
+    board.RollbackTrail(stallmark);
+    TEST_CHECK(board.GetTrailMark() == stallmark);
+    TEST_CHECK(board.GetCore().IsEqual(stalled.core));
+    TEST_CHECK(board.IsCoreInSync());
+
+    board.RollbackTrail(loadmark);
+    TEST_CHECK(board.GetCore().IsEqual(loaded.core));
+    TEST_CHECK(board.IsCoreInSync());
+}
+
+static void TestSnapshotAcrossBoards()
+{
+    SudokuBoard first;
+    SudokuBoard second;
+    SudokuBoard fresh;
+    BoardSnapshot loaded;
+    BoardSnapshot solved;
+    SolveResult result;
+    SolveResult freshresult;
+
+    first.SetLogLevel(LOG_OFF);
+    second.SetLogLevel(LOG_OFF);
+    fresh.SetLogLevel(LOG_OFF);
+
+    TEST_CHECK(first.LoadFromString(g_inputPuzzle));
+    first.SaveSnapshot(loaded);
+    TEST_CHECK(first.Solve());
+    first.SaveSnapshot(solved);
+
+    // a board in the middle of a different puzzle takes the loaded state and solves it the same way
+    TEST_CHECK(second.LoadFromString(g_hardPuzzle));
+    second.Solve();
+    second.RestoreSnapshot(loaded);
+    TEST_CHECK(second.GetCore().IsEqual(loaded.core));
+    TEST_CHECK(second.IsCoreInSync());
+
+    TEST_CHECK(fresh.LoadFromString(g_inputPuzzle));
+    TEST_CHECK(second.Solve(result));
+    TEST_CHECK(fresh.Solve(freshresult));
+    TEST_CHECK(strcmp(result.grid, freshresult.grid) == 0);
+    TEST_CHECK(second.GetCore().IsEqual(solved.core));
+
+    // and back the other way, onto the board the snapshot came from
+    second.SaveSnapshot(solved);
+    first.Reset();
+    TEST_CHECK(first.LoadFromString(g_hardPuzzle));
+    first.RestoreSnapshot(solved);
+    TEST_CHECK(first.GetCore().IsEqual(solved.core));
+    TEST_CHECK(first.IsCoreInSync());
+    TEST_CHECK(first.IsSolved());
+}
+
+static void TestNakedSubsets()
+{
+    TestBoard board;
+    BoardSnapshot before;
+    uint16_t removed[81] = {};
+
+    board.SetLogLevel(LOG_OFF);
+    TEST_CHECK(board.LoadFromString(std::string(81, '.')));
+
+    // a naked triple in row 0: the first three cells hold 1, 2, and 3 between them
+    board.KeepCandidates(0, ValueMask({ 1, 2 }));
+    board.KeepCandidates(1, ValueMask({ 2, 3 }));
+    board.KeepCandidates(2, ValueMask({ 1, 3 }));
+    board.SaveSnapshot(before);
+
+    // so 1, 2, and 3 come out of the rest of the row and nothing else changes
+    for (int cellindex = 3; cellindex < 9; cellindex++)
+    {
+        removed[cellindex] = ValueMask({ 1, 2, 3 });
+    }
+
+    TEST_CHECK(board.NakedSubsets(SET_ROW_BASE + 0) == 18);
+    TEST_CHECK(CountUnexpectedMasks(before.core, board.GetCore(), removed) == 0);
+    TEST_CHECK(board.IsCoreInSync());
+}
+
+static void TestHiddenSubsets()
+{
+    TestBoard board;
+    BoardSnapshot before;
+    uint16_t removed[81] = {};
+
+    board.SetLogLevel(LOG_OFF);
+    TEST_CHECK(board.LoadFromString(std::string(81, '.')));
+
+    // a hidden pair in column 4: 1 and 2 can only go in rows 3 and 7
+    for (int row = 0; row < 9; row++)
+    {
+        if ((row != 3) && (row != 7))
+        {
+            board.KeepCandidates((row * 9) + 4, ValueMask({ 3, 4, 5, 6, 7, 8, 9 }));
+        }
+    }
+    board.SaveSnapshot(before);
+
+    // so those two cells lose every other candidate and nothing else changes
+    removed[(3 * 9) + 4] = ValueMask({ 3, 4, 5, 6, 7, 8, 9 });
+    removed[(7 * 9) + 4] = ValueMask({ 3, 4, 5, 6, 7, 8, 9 });
+
+    TEST_CHECK(board.HiddenSubsets(SET_COLUMN_BASE + 4) == 14);
+    TEST_CHECK(CountUnexpectedMasks(before.core, board.GetCore(), removed) == 0);
+    TEST_CHECK(board.IsCoreInSync());
+}
+
+static void TestFishSearch()
+{
+    TestBoard board;
+    BoardSnapshot before;
+    uint16_t removed[81] = {};
+
+    board.SetLogLevel(LOG_OFF);
+    TEST_CHECK(board.LoadFromString(std::string(81, '.')));
+
+    // a swordfish on 4: rows 1, 4, and 7 only have it in columns 0 and 4, 4 and 8, and 0 and 8
+    const int rows[3] = { 1, 4, 7 };
+    const uint16_t wColumns[3] = { 0x011, 0x110, 0x101 };  // bit N is column N
+
+    for (int index = 0; index < 3; index++)
+    {
+        for (int col = 0; col < 9; col++)
+        {
+            if ((wColumns[index] & (0x01 << col)) == 0)
+            {
+                board.KeepCandidates((rows[index] * 9) + col, (uint16_t)(CELLINIT & ~ValueMask({ 4 })));
+            }
+        }
+    }
+    board.SaveSnapshot(before);
+
+    // so 4 comes out of columns 0, 4, and 8 in the other six rows and nothing else changes
+    for (int row = 0; row < 9; row++)
+    {
+        if ((row != 1) && (row != 4) && (row != 7))
+        {
+            removed[(row * 9) + 0] = ValueMask({ 4 });
+            removed[(row * 9) + 4] = ValueMask({ 4 });
+            removed[(row * 9) + 8] = ValueMask({ 4 });
+        }
+    }
+
+    TEST_CHECK(board.FishSearch(SET_ROW_BASE) == 18);
+    TEST_CHECK(CountUnexpectedMasks(before.core, board.GetCore(), removed) == 0);
+    TEST_CHECK(board.IsCoreInSync());
+
+    // the columns are now a swordfish the other way around, which has nothing left to remove
+    TEST_CHECK(board.FishSearch(SET_COLUMN_BASE) == 0);
+}
+
+static void TestLockedCandidates()
+{
+    TestBoard board;
+    BoardSnapshot before;
+    uint16_t removed[81] = {};
+
+    board.SetLogLevel(LOG_OFF);
+    TEST_CHECK(board.LoadFromString(std::string(81, '.')));
+
+    // intersection 0 is row 0 and square 0, sharing cells 0, 1, and 2.  Square 0 only has 5 in the shared cells
+    // (cells 9-11 and 18-20 lose it), and row 0 only has 7 in them (cells 3-8 lose it)
+    const int squarerest[6] = { 9, 10, 11, 18, 19, 20 };
+
+    for (int cellindex : squarerest)
+    {
+        board.KeepCandidates(cellindex, (uint16_t)(CELLINIT & ~ValueMask({ 5 })));
+    }
+    for (int cellindex = 3; cellindex < 9; cellindex++)
+    {
+        board.KeepCandidates(cellindex, (uint16_t)(CELLINIT & ~ValueMask({ 7 })));
+    }
+    board.SaveSnapshot(before);
+
+    // number claiming takes 5 out of the rest of the row, box line reduction takes 7 out of the rest of the square
+    for (int cellindex = 3; cellindex < 9; cellindex++)
+    {
+        removed[cellindex] = ValueMask({ 5 });
+    }
+    for (int cellindex : squarerest)
+    {
+        removed[cellindex] = ValueMask({ 7 });
+    }
+
+    TEST_CHECK(board.LockedCandidates(0) == 12);
+    TEST_CHECK(CountUnexpectedMasks(before.core, board.GetCore(), removed) == 0);
+    TEST_CHECK(board.IsCoreInSync());
+}
+
+static void TestContradictionBeforeFirstPass()
+{
+    const SOLVE_ENGINE engines[] = { ENGINE_SCAN, ENGINE_PROPAGATE, ENGINE_ADAPTIVE };
+    SudokuBoard board;
+    SolveResult result;
+
+    // the last cell of row 0 can't hold 9 (column 8 has it) or 1-8 (the rest of the row), while row 7 has a single
+    // left that a pass would fill in
+    const char *puzzle = "12345678.............................................9.........23456789..........";
+
+    board.SetLogLevel(LOG_OFF);
+
+    for (SOLVE_ENGINE engine : engines)
+    {
+        board.Reset();
+        board.SetEngine(engine);
+        TEST_CHECK(board.LoadFromString(puzzle));
+        TEST_CHECK(board.HasContradiction());
+        TEST_CHECK(board.Solve(result) == false);
+        TEST_CHECK(result.status == STATUS_INVALID);
+        TEST_CHECK(result.scancount == 0);
+        TEST_CHECK(strcmp(result.grid, puzzle) == 0);
+    }
+}
+
+static void TestCoreInSyncAfterSolve()
+{
+    const SOLVE_ENGINE engines[] = { ENGINE_SCAN, ENGINE_PROPAGATE, ENGINE_ADAPTIVE };
+    const char *puzzles[] = { g_inputPuzzle, g_hardPuzzle, g_duplicateGrid };
+    SudokuBoard board;
+
+    board.SetLogLevel(LOG_OFF);
+
+    // Solve no longer checks the core against the cells on every call, so check it here for every engine
+    for (SOLVE_ENGINE engine : engines)
+    {
+        for (int search = 0; search < 2; search++)
+        {
+            for (const char *puzzle : puzzles)
+            {
+                board.Reset();
+                board.SetEngine(engine);
+                board.SetSearchFallback(search != 0);
+                TEST_CHECK(board.LoadFromString(puzzle));
+                board.Solve();
+                TEST_CHECK(board.IsCoreInSync());
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    TestFilledValidGrid();
+    TestFilledDuplicateGrid();
+    TestBufferLength();
+    TestResetMatchesNewBoard();
+    TestCountSolutionsKeepsTrail();
+    TestSnapshotAcrossBoards();
+    TestRollbackToMiddleOfSolve();
+    TestCoreInSyncAfterSolve();
+    TestNakedSubsets();
+    TestHiddenSubsets();
+    TestFishSearch();
+    TestLockedCandidates();
+    TestContradictionBeforeFirstPass();
+
+    if (g_failures == 0)
+    {
+        std::cout << "All tests passed" << std::endl;
+    }
+
+    return g_failures;
+}